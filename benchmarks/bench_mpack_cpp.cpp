@@ -0,0 +1,405 @@
+/** Encode/decode benchmarks.
+ *
+ * Every message shape is benchmarked with the writer, the node reader and, where
+ * the shape is supported, the expect reader. The `raw_*` benchmarks do the same
+ * work for the flat shape with direct mpack calls, to make the overhead of the
+ * wrapper visible.
+ *
+ * All input data is generated deterministically, so results are comparable
+ * between runs. Build with `-DMPACK_CPP_BUILD_BENCHMARKS=ON`.
+ */
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "mpack.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// Message shapes
+///////////////////////////////////////////////////////////////////////////////
+
+// The node and expect macros define the same encoder, so each shape has its
+// fields in a base struct and one derived struct per reader.
+
+struct FlatFields {
+    bool active;
+    std::uint32_t id;
+    std::int64_t offset;
+    double value;
+    std::string label;
+};
+
+struct Flat : FlatFields {
+    MPACK_CPP_DEFINE(Flat, active, id, offset, value, label)
+};
+
+struct FlatExpect : FlatFields {
+    MPACK_CPP_EXPECT_DEFINE(FlatExpect, active, id, offset, value, label)
+};
+
+struct AnimalFields {
+    std::string name;
+    int age;
+};
+
+struct Animal : AnimalFields {
+    MPACK_CPP_DEFINE(Animal, name, age)
+};
+
+struct AnimalExpect : AnimalFields {
+    MPACK_CPP_EXPECT_DEFINE(AnimalExpect, name, age)
+};
+
+struct Zoo {
+    std::vector<Animal> animals;
+    MPACK_CPP_DEFINE(Zoo, animals)
+};
+
+struct ZooExpect {
+    std::vector<AnimalExpect> animals;
+    MPACK_CPP_EXPECT_DEFINE(ZooExpect, animals)
+};
+
+struct Samples {
+    std::vector<double> values;
+    std::vector<std::int32_t> counts;
+    MPACK_CPP_DEFINE(Samples, values, counts)
+};
+
+struct SamplesExpect {
+    std::vector<double> values;
+    std::vector<std::int32_t> counts;
+    MPACK_CPP_EXPECT_DEFINE(SamplesExpect, values, counts)
+};
+
+struct Log {
+    std::string host;
+    std::vector<std::string> lines;
+    MPACK_CPP_DEFINE(Log, host, lines)
+};
+
+struct LogExpect {
+    std::string host;
+    std::vector<std::string> lines;
+    MPACK_CPP_EXPECT_DEFINE(LogExpect, host, lines)
+};
+
+struct Optionals {
+    std::optional<int> first;
+    std::optional<double> second;
+    std::optional<std::string> third;
+    int always;
+    MPACK_CPP_DEFINE(Optionals, first, second, third, always)
+};
+
+using Setting = std::pair<std::string, std::variant<bool, double>>;
+
+struct Settings {
+    std::vector<Setting> entries;
+    MPACK_CPP_DEFINE(Settings, entries)
+};
+
+struct SettingsExpect {
+    std::vector<Setting> entries;
+    MPACK_CPP_EXPECT_DEFINE(SettingsExpect, entries)
+};
+
+template <typename T>
+T MakeFlat() {
+    T msg{};
+    msg.active = true;
+    msg.id = 123456;
+    msg.offset = -987654321;
+    msg.value = 3.14159;
+    msg.label = "sensor/front/left";
+    return msg;
+}
+
+template <typename ZooT>
+ZooT MakeZoo(int count) {
+    ZooT zoo{};
+    zoo.animals.resize(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        auto& animal = zoo.animals[static_cast<std::size_t>(i)];
+        animal.name = "animal_" + std::to_string(i);
+        animal.age = i % 40;
+    }
+    return zoo;
+}
+
+template <typename T>
+T MakeSamples(std::size_t count) {
+    T samples{};
+    samples.values.resize(count);
+    samples.counts.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        samples.values[i] = static_cast<double>(i) * 0.25 - 100.0;
+        samples.counts[i] = static_cast<std::int32_t>(i * 7919 % 100000) - 50000;
+    }
+    return samples;
+}
+
+template <typename T>
+T MakeLog(std::size_t count) {
+    T log{};
+    log.host = "worker-17.example.internal";
+    log.lines.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        log.lines[i] = "2024-01-01T00:00:00Z INFO request " + std::to_string(i) +
+                       " handled in " + std::to_string(i % 1000) + "us";
+    }
+    return log;
+}
+
+Optionals MakeOptionals() { return Optionals{1, std::nullopt, "present", 4}; }
+
+template <typename T>
+T MakeSettings(std::size_t count) {
+    T settings{};
+    for (std::size_t i = 0; i < count; ++i) {
+        std::variant<bool, double> value{i % 2 == 0};
+        if (i % 3 == 0) {
+            value = static_cast<double>(i) / 3.0;
+        }
+        settings.entries.emplace_back("setting_" + std::to_string(i), value);
+    }
+    return settings;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Generic benchmarks
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::vector<char> Encode(const T& msg) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(msg, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+
+/** Report throughput in bytes/s and messages/s. */
+void Report(benchmark::State& state, std::size_t msg_size) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(msg_size));
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    state.counters["msg_bytes"] = static_cast<double>(msg_size);
+}
+
+template <typename T>
+void BM_Write(benchmark::State& state, T msg) {
+    std::vector<char> buffer(Encode(msg).size());
+    std::size_t n{0};
+    for (auto _ : state) {
+        n = mpack_cpp::WriteToMsgPack(msg, buffer);
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+    if (n == 0) {
+        state.SkipWithError("encoding failed");
+    }
+    Report(state, n);
+}
+
+template <typename T>
+void BM_NodeRead(benchmark::State& state, T msg) {
+    const auto buffer = Encode(msg);
+    T out{};
+    for (auto _ : state) {
+        if (!mpack_cpp::ReadFromMsgPack(out, buffer, buffer.size())) {
+            state.SkipWithError("decoding failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, buffer.size());
+}
+
+template <typename T>
+void BM_DecoderRead(benchmark::State& state, T msg) {
+    const auto buffer = Encode(msg);
+    mpack_cpp::Decoder decoder;
+    T out{};
+    for (auto _ : state) {
+        if (!decoder.Read(out, buffer, buffer.size())) {
+            state.SkipWithError("decoding failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, buffer.size());
+}
+
+template <typename T>
+void BM_ExpectRead(benchmark::State& state, T msg) {
+    const auto buffer = Encode(msg);
+    T out{};
+    for (auto _ : state) {
+        if (!mpack_cpp::expect::ReadFromMsgPack(out, buffer, buffer.size())) {
+            state.SkipWithError("decoding failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, buffer.size());
+}
+
+/** Macro benchmark: encode into a reused growable buffer and decode again. */
+template <typename T>
+void BM_RoundTrip(benchmark::State& state, T msg) {
+    std::vector<char> buffer;
+    mpack_cpp::Decoder decoder;
+    T out{};
+    std::size_t n{0};
+    for (auto _ : state) {
+        buffer.clear();
+        n = mpack_cpp::WriteToMsgPack(msg, mpack_cpp::GrowableBuffer{buffer});
+        if (n == 0 || !decoder.Read(out, buffer, n)) {
+            state.SkipWithError("round trip failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, n);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Raw mpack baseline for the flat shape
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t RawWriteFlat(const FlatFields& msg, char* buffer, std::size_t size) {
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer, size);
+    mpack_start_map(&writer, 5);
+    mpack_write_cstr(&writer, "active");
+    mpack_write_bool(&writer, msg.active);
+    mpack_write_cstr(&writer, "id");
+    mpack_write_u32(&writer, msg.id);
+    mpack_write_cstr(&writer, "offset");
+    mpack_write_i64(&writer, msg.offset);
+    mpack_write_cstr(&writer, "value");
+    mpack_write_double(&writer, msg.value);
+    mpack_write_cstr(&writer, "label");
+    mpack_write_utf8(&writer, msg.label.data(),
+                     static_cast<std::uint32_t>(msg.label.size()));
+    mpack_finish_map(&writer);
+    std::size_t n = mpack_writer_buffer_used(&writer);
+    return mpack_writer_destroy(&writer) == mpack_ok ? n : 0;
+}
+
+void BM_RawWriteFlat(benchmark::State& state) {
+    const auto msg = MakeFlat<Flat>();
+    std::vector<char> buffer(Encode(msg).size());
+    std::size_t n{0};
+    for (auto _ : state) {
+        n = RawWriteFlat(msg, buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+    if (n == 0) {
+        state.SkipWithError("encoding failed");
+    }
+    Report(state, n);
+}
+
+void BM_RawNodeReadFlat(benchmark::State& state) {
+    const auto buffer = Encode(MakeFlat<Flat>());
+    FlatFields out{};
+    for (auto _ : state) {
+        mpack_tree_t tree;
+        mpack_tree_init_data(&tree, buffer.data(), buffer.size());
+        mpack_tree_parse(&tree);
+        mpack_node_t root = mpack_tree_root(&tree);
+        out.active = mpack_node_bool(mpack_node_map_cstr(root, "active"));
+        out.id = mpack_node_u32(mpack_node_map_cstr(root, "id"));
+        out.offset = mpack_node_i64(mpack_node_map_cstr(root, "offset"));
+        out.value = mpack_node_double(mpack_node_map_cstr(root, "value"));
+        auto label = mpack_node_map_cstr(root, "label");
+        out.label.assign(mpack_node_str(label), mpack_node_strlen(label));
+        if (mpack_tree_destroy(&tree) != mpack_ok) {
+            state.SkipWithError("decoding failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, buffer.size());
+}
+
+void BM_RawExpectReadFlat(benchmark::State& state) {
+    const auto buffer = Encode(MakeFlat<Flat>());
+    FlatFields out{};
+    for (auto _ : state) {
+        mpack_reader_t reader;
+        mpack_reader_init_data(&reader, buffer.data(), buffer.size());
+        mpack_expect_map_match(&reader, 5);
+        mpack_expect_cstr_match(&reader, "active");
+        out.active = mpack_expect_bool(&reader);
+        mpack_expect_cstr_match(&reader, "id");
+        out.id = mpack_expect_u32(&reader);
+        mpack_expect_cstr_match(&reader, "offset");
+        out.offset = mpack_expect_i64(&reader);
+        mpack_expect_cstr_match(&reader, "value");
+        out.value = mpack_expect_double(&reader);
+        mpack_expect_cstr_match(&reader, "label");
+        auto length = mpack_expect_str(&reader);
+        out.label.resize(length);
+        mpack_read_bytes(&reader, out.label.data(), length);
+        mpack_done_str(&reader);
+        mpack_done_map(&reader);
+        if (mpack_reader_destroy(&reader) != mpack_ok) {
+            state.SkipWithError("decoding failed");
+            break;
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    Report(state, buffer.size());
+}
+
+}  // namespace
+
+// clang-format off
+BENCHMARK_CAPTURE(BM_Write, flat, MakeFlat<Flat>());
+BENCHMARK_CAPTURE(BM_NodeRead, flat, MakeFlat<Flat>());
+BENCHMARK_CAPTURE(BM_DecoderRead, flat, MakeFlat<Flat>());
+BENCHMARK_CAPTURE(BM_ExpectRead, flat, MakeFlat<FlatExpect>());
+BENCHMARK(BM_RawWriteFlat);
+BENCHMARK(BM_RawNodeReadFlat);
+BENCHMARK(BM_RawExpectReadFlat);
+
+BENCHMARK_CAPTURE(BM_Write, zoo_64, MakeZoo<Zoo>(64));
+BENCHMARK_CAPTURE(BM_NodeRead, zoo_64, MakeZoo<Zoo>(64));
+BENCHMARK_CAPTURE(BM_DecoderRead, zoo_64, MakeZoo<Zoo>(64));
+BENCHMARK_CAPTURE(BM_ExpectRead, zoo_64, MakeZoo<ZooExpect>(64));
+
+BENCHMARK_CAPTURE(BM_Write, samples_100k, MakeSamples<Samples>(100000));
+BENCHMARK_CAPTURE(BM_NodeRead, samples_100k, MakeSamples<Samples>(100000));
+BENCHMARK_CAPTURE(BM_DecoderRead, samples_100k, MakeSamples<Samples>(100000));
+BENCHMARK_CAPTURE(BM_ExpectRead, samples_100k, MakeSamples<SamplesExpect>(100000));
+
+BENCHMARK_CAPTURE(BM_Write, log_64, MakeLog<Log>(64));
+BENCHMARK_CAPTURE(BM_NodeRead, log_64, MakeLog<Log>(64));
+BENCHMARK_CAPTURE(BM_DecoderRead, log_64, MakeLog<Log>(64));
+BENCHMARK_CAPTURE(BM_ExpectRead, log_64, MakeLog<LogExpect>(64));
+
+BENCHMARK_CAPTURE(BM_Write, optionals, MakeOptionals());
+BENCHMARK_CAPTURE(BM_NodeRead, optionals, MakeOptionals());
+BENCHMARK_CAPTURE(BM_DecoderRead, optionals, MakeOptionals());
+
+BENCHMARK_CAPTURE(BM_Write, settings_64, MakeSettings<Settings>(64));
+BENCHMARK_CAPTURE(BM_NodeRead, settings_64, MakeSettings<Settings>(64));
+BENCHMARK_CAPTURE(BM_DecoderRead, settings_64, MakeSettings<Settings>(64));
+BENCHMARK_CAPTURE(BM_ExpectRead, settings_64, MakeSettings<SettingsExpect>(64));
+
+BENCHMARK_CAPTURE(BM_RoundTrip, zoo_10k, MakeZoo<Zoo>(10000));
+// clang-format on
+
+BENCHMARK_MAIN();
@@ -0,0 +1,180 @@
+#ifndef MPACK_CPP__MPACK_ASYNC_HPP_
+#define MPACK_CPP__MPACK_ASYNC_HPP_
+
+/** Coroutine API to encode and decode messages on non-blocking file descriptors.
+ *
+ * Requires C++20 coroutines and POSIX file descriptors, the header is empty
+ * otherwise. With C++17 the same building blocks can be driven from callbacks:
+ * `StreamDecoder` for decoding and `FrameDecoder` / `WriteFrame` for framed
+ * streams.
+ *
+ * The coroutines are executor agnostic, they suspend on an awaitable provided by
+ * the caller whenever the file descriptor would block:
+ *
+ * ```
+ * mpack_cpp::StreamDecoder decoder(mpack_cpp::FileDescriptor{socket});
+ * bool ok = co_await mpack_cpp::AsyncReadFromMsgPack(
+ *     msg, decoder, [&] { return loop.Readable(socket); });
+ * ```
+ *
+ * Neither direction streams through a small fixed buffer. Decoding keeps the
+ * received part of the current message in the `StreamDecoder`, because the node
+ * tree needs the whole message. Encoding writes the message into a scratch
+ * buffer first. Both buffers are reused, so after warm-up each connection holds
+ * about one message of its largest size.
+ */
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>) && \
+    __has_include(<unistd.h>)
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <coroutine>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+#define MPACK_CPP_HAS_COROUTINES 1
+
+namespace mpack_cpp {
+
+/** Lazily started coroutine returning a `T`, awaitable from other coroutines.
+ *
+ * Code outside coroutines can drive it with `Resume`, `done` and `result`.
+ */
+template <typename T>
+class Task {
+   public:
+    struct promise_type {
+        std::optional<T> value;
+        std::coroutine_handle<> continuation{std::noop_coroutine()};
+
+        Task get_return_object() {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> handle) noexcept {
+                return handle.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+    T await_resume() { return std::move(*handle_.promise().value); }
+
+    /** Run until the next suspension point, for use outside coroutines. */
+    void Resume() {
+        if (!handle_.done()) {
+            handle_.resume();
+        }
+    }
+
+    bool done() const { return handle_.done(); }
+
+    /** The returned value, only valid once `done()`. */
+    const T& result() const { return *handle_.promise().value; }
+
+   private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/** Decode the next message, suspending on `wait_readable()` while it is incomplete.
+ *
+ * The decoder keeps the parse state between suspensions, so bytes are parsed only
+ * once. The received bytes of the message stay buffered in the decoder until it
+ * is complete. `wait_readable` returns an awaitable that resumes the coroutine when more
+ * input is available.
+ */
+template <typename T, typename WaitT>
+Task<bool> AsyncReadFromMsgPack(T& data, StreamDecoder& decoder, WaitT wait_readable) {
+    while (true) {
+        switch (decoder.TryRead(data)) {
+            case StreamDecoder::Status::kComplete:
+                co_return true;
+            case StreamDecoder::Status::kError:
+                co_return false;
+            case StreamDecoder::Status::kIncomplete:
+                co_await wait_readable();
+                break;
+        }
+    }
+}
+
+/** Encode a message and write it, suspending on `wait_writable()` while the file
+ * descriptor would block.
+ *
+ * The message is encoded in `scratch`, which is reused between calls. Encoding
+ * itself never blocks, only writing suspends.
+ */
+template <typename T, typename WaitT>
+Task<bool> AsyncWriteToMsgPack(const T& data, FileDescriptor file,
+                               std::vector<char>& scratch, WaitT wait_writable) {
+    scratch.clear();
+    const std::size_t n = WriteToMsgPack(data, GrowableBuffer{scratch});
+    if (n == 0) {
+        co_return false;
+    }
+    std::size_t offset{0};
+    while (offset < n) {
+        ssize_t written = ::write(file.fd, scratch.data() + offset, n - offset);
+        if (written > 0) {
+            offset += static_cast<std::size_t>(written);
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await wait_writable();
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else {
+            fprintf(stderr, "An error occurred writing the data!\n");
+            fprintf(stderr, "%s!\n", std::strerror(errno));
+            co_return false;
+        }
+    }
+    co_return true;
+}
+
+}  // namespace mpack_cpp
+
+#endif  // C++20 coroutines and <unistd.h>
+
+#endif  //  MPACK_CPP__MPACK_ASYNC_HPP_
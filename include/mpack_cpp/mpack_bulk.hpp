@@ -0,0 +1,389 @@
+#ifndef MPACK_CPP__MPACK_BULK_HPP_
+#define MPACK_CPP__MPACK_BULK_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "mpack.h"  //  NOLINT
+
+/** Kernels to encode and decode contiguous arrays of numbers in bulk.
+ *
+ * These bypass the per-element mpack calls (type tag, bounds and error checks for
+ * every value) and produce exactly the same bytes as `mpack_write_u32` and friends.
+ */
+namespace mpack_cpp {
+namespace internal {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool kLittleEndian = false;
+#else
+constexpr bool kLittleEndian = true;
+#endif
+
+// Reading or writing elements without mpack calls would break mpack's element tracking.
+#if MPACK_WRITE_TRACKING
+constexpr bool kWriteTracking = true;
+#else
+constexpr bool kWriteTracking = false;
+#endif
+#if MPACK_READ_TRACKING
+constexpr bool kReadTracking = true;
+#else
+constexpr bool kReadTracking = false;
+#endif
+
+/** Number types with a dedicated overload in the visitors, `bool` is excluded
+ * because `std::vector<bool>` is not contiguous.
+ */
+template <typename T>
+struct IsBulkNumber
+    : std::bool_constant<
+          std::is_same_v<T, float> || std::is_same_v<T, double> ||
+          std::is_same_v<T, std::uint8_t> || std::is_same_v<T, std::uint16_t> ||
+          std::is_same_v<T, std::uint32_t> || std::is_same_v<T, std::uint64_t> ||
+          std::is_same_v<T, std::int8_t> || std::is_same_v<T, std::int16_t> ||
+          std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::int64_t>> {};
+
+/** Unsigned integer with the same size as T, used for byte level operations. */
+template <std::size_t Size>
+struct UintOfSize;
+template <>
+struct UintOfSize<1> {
+    using type = std::uint8_t;
+};
+template <>
+struct UintOfSize<2> {
+    using type = std::uint16_t;
+};
+template <>
+struct UintOfSize<4> {
+    using type = std::uint32_t;
+};
+template <>
+struct UintOfSize<8> {
+    using type = std::uint64_t;
+};
+
+// Written with shifts so compilers emit a single bswap instruction.
+inline std::uint8_t ByteSwap(std::uint8_t value) { return value; }
+inline std::uint16_t ByteSwap(std::uint16_t value) {
+    return static_cast<std::uint16_t>((value >> 8) | (value << 8));
+}
+inline std::uint32_t ByteSwap(std::uint32_t value) {
+    return ((value & 0xff000000u) >> 24) | ((value & 0x00ff0000u) >> 8) |
+           ((value & 0x0000ff00u) << 8) | ((value & 0x000000ffu) << 24);
+}
+inline std::uint64_t ByteSwap(std::uint64_t value) {
+    auto low = static_cast<std::uint64_t>(ByteSwap(static_cast<std::uint32_t>(value)));
+    return (low << 32) | ByteSwap(static_cast<std::uint32_t>(value >> 32));
+}
+
+template <typename T>
+void StoreBigEndian(char* out, T value) {
+    using U = typename UintOfSize<sizeof(T)>::type;
+    U bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    if constexpr (kLittleEndian) {
+        bits = ByteSwap(bits);
+    }
+    std::memcpy(out, &bits, sizeof(T));
+}
+
+template <typename T>
+T LoadBigEndian(const char* in) {
+    using U = typename UintOfSize<sizeof(T)>::type;
+    U bits;
+    std::memcpy(&bits, in, sizeof(T));
+    if constexpr (kLittleEndian) {
+        bits = ByteSwap(bits);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+/** Copy `count` numbers between native and little-endian byte order. */
+template <typename T>
+void CopyLittleEndian(char* out, const char* in, std::size_t count) {
+    if constexpr (kLittleEndian || sizeof(T) == 1) {
+        std::memcpy(out, in, count * sizeof(T));
+    } else {
+        using U = typename UintOfSize<sizeof(T)>::type;
+        for (std::size_t i{0}; i < count; ++i) {
+            U bits;
+            std::memcpy(&bits, in + i * sizeof(T), sizeof(T));
+            bits = ByteSwap(bits);
+            std::memcpy(out + i * sizeof(T), &bits, sizeof(T));
+        }
+    }
+}
+
+/** Largest encoded size of a single value of type T. */
+template <typename T>
+constexpr std::size_t kMaxEncodedSize = 1 + sizeof(T);
+
+/** Encode an unsigned integer in the smallest format, like `mpack_write_u64`. */
+inline char* EncodeUint(char* out, std::uint64_t value) {
+    if (value <= 0x7f) {
+        *out++ = static_cast<char>(value);  // positive fixint
+    } else if (value <= std::numeric_limits<std::uint8_t>::max()) {
+        *out++ = static_cast<char>(0xcc);
+        *out++ = static_cast<char>(value);
+    } else if (value <= std::numeric_limits<std::uint16_t>::max()) {
+        *out++ = static_cast<char>(0xcd);
+        StoreBigEndian(out, static_cast<std::uint16_t>(value));
+        out += 2;
+    } else if (value <= std::numeric_limits<std::uint32_t>::max()) {
+        *out++ = static_cast<char>(0xce);
+        StoreBigEndian(out, static_cast<std::uint32_t>(value));
+        out += 4;
+    } else {
+        *out++ = static_cast<char>(0xcf);
+        StoreBigEndian(out, value);
+        out += 8;
+    }
+    return out;
+}
+
+/** Encode a signed integer in the smallest format, like `mpack_write_i64`.
+ *
+ * Positive values use the unsigned formats.
+ */
+inline char* EncodeInt(char* out, std::int64_t value) {
+    if (value >= 0) {
+        return EncodeUint(out, static_cast<std::uint64_t>(value));
+    }
+    if (value >= -32) {
+        *out++ = static_cast<char>(value);  // negative fixint
+    } else if (value >= std::numeric_limits<std::int8_t>::min()) {
+        *out++ = static_cast<char>(0xd0);
+        *out++ = static_cast<char>(value);
+    } else if (value >= std::numeric_limits<std::int16_t>::min()) {
+        *out++ = static_cast<char>(0xd1);
+        StoreBigEndian(out, static_cast<std::int16_t>(value));
+        out += 2;
+    } else if (value >= std::numeric_limits<std::int32_t>::min()) {
+        *out++ = static_cast<char>(0xd2);
+        StoreBigEndian(out, static_cast<std::int32_t>(value));
+        out += 4;
+    } else {
+        *out++ = static_cast<char>(0xd3);
+        StoreBigEndian(out, value);
+        out += 8;
+    }
+    return out;
+}
+
+template <typename T>
+char* EncodeNumber(char* out, T value) {
+    if constexpr (std::is_same_v<T, float>) {
+        *out++ = static_cast<char>(0xca);
+        StoreBigEndian(out, value);
+        return out + 4;
+    } else if constexpr (std::is_same_v<T, double>) {
+        *out++ = static_cast<char>(0xcb);
+        StoreBigEndian(out, value);
+        return out + 8;
+    } else if constexpr (std::is_signed_v<T>) {
+        return EncodeInt(out, value);
+    } else {
+        return EncodeUint(out, value);
+    }
+}
+
+template <typename T>
+char* EncodeNumbers(char* out, const T* values, std::size_t count) {
+    for (std::size_t i{0}; i < count; ++i) {
+        out = EncodeNumber(out, values[i]);
+    }
+    return out;
+}
+
+/** Write the elements of an already started array of numbers.
+ *
+ * Elements are encoded straight into the writer's buffer as long as there is
+ * room for the worst case size. Otherwise, they are encoded into a small chunk
+ * on the stack that is handed to mpack, which takes care of flushing or
+ * starting a new builder page.
+ *
+ * Requires `kWriteTracking` to be false, the elements are not tracked by mpack.
+ */
+template <typename T>
+void WriteNumbers(mpack_writer_t& writer, const T* values, std::size_t count) {
+    constexpr std::size_t kChunkSize{512};
+    constexpr std::size_t kMaxSize = kMaxEncodedSize<T>;
+
+    std::size_t i{0};
+    while (i < count && mpack_writer_error(&writer) == mpack_ok) {
+        std::size_t fits = mpack_writer_buffer_left(&writer) / kMaxSize;
+        if (fits > 0) {
+            std::size_t n = std::min(fits, count - i);
+            writer.position = EncodeNumbers(writer.position, values + i, n);
+            i += n;
+        } else {
+            char chunk[kChunkSize];
+            std::size_t n = std::min(kChunkSize / kMaxSize, count - i);
+            char* end = EncodeNumbers(chunk, values + i, n);
+            auto size = static_cast<std::size_t>(end - chunk);
+            mpack_write_object_bytes(&writer, chunk, size);
+            i += n;
+        }
+    }
+}
+
+/** Assign an integer to `out` if it is in range of T. */
+template <typename T>
+bool FitInteger(std::uint64_t value, T& out) {
+    if (value > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+}
+
+template <typename T>
+bool FitInteger(std::int64_t value, T& out) {
+    if (value >= 0) {
+        return FitInteger(static_cast<std::uint64_t>(value), out);
+    }
+    if constexpr (std::is_signed_v<T>) {
+        if (value >= static_cast<std::int64_t>(std::numeric_limits<T>::min())) {
+            out = static_cast<T>(value);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Decode a single number from raw MessagePack data.
+ *
+ * Only handles the cases where the result is the same as the corresponding
+ * `mpack_expect_*` call: floats from 'float32', doubles from 'float64' and integers
+ * from any integer format if the value is in range. Returns false, without
+ * consuming anything, for all other cases and when `in` does not hold the
+ * complete value, so the caller can fall back to mpack.
+ */
+template <typename T>
+bool DecodeNumber(const char*& in, const char* end, T& out) {
+    const auto available = static_cast<std::size_t>(end - in);
+    if (available == 0) {
+        return false;
+    }
+    const auto tag = static_cast<std::uint8_t>(*in);
+
+    if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+        constexpr std::uint8_t kTag = std::is_same_v<T, float> ? 0xca : 0xcb;
+        if (tag != kTag || available < 1 + sizeof(T)) {
+            return false;
+        }
+        out = LoadBigEndian<T>(in + 1);
+        in += 1 + sizeof(T);
+        return true;
+    } else {
+        if (tag <= 0x7f || tag >= 0xe0) {  // positive and negative fixint
+            auto value = static_cast<std::int64_t>(static_cast<std::int8_t>(tag));
+            if (!FitInteger(value, out)) {
+                return false;
+            }
+            in += 1;
+            return true;
+        }
+        // uint8/16/32/64 are tags 0xcc-0xcf, int8/16/32/64 are tags 0xd0-0xd3.
+        if (tag < 0xcc || tag > 0xd3) {
+            return false;
+        }
+        const bool is_signed = tag >= 0xd0;
+        const std::size_t size = std::size_t{1} << (tag - (is_signed ? 0xd0 : 0xcc));
+        if (available < 1 + size) {
+            return false;
+        }
+        bool fits{false};
+        const char* p = in + 1;
+        switch (tag) {
+            case 0xcc:
+                fits = FitInteger(std::uint64_t{LoadBigEndian<std::uint8_t>(p)}, out);
+                break;
+            case 0xcd:
+                fits = FitInteger(std::uint64_t{LoadBigEndian<std::uint16_t>(p)}, out);
+                break;
+            case 0xce:
+                fits = FitInteger(std::uint64_t{LoadBigEndian<std::uint32_t>(p)}, out);
+                break;
+            case 0xcf:
+                fits = FitInteger(LoadBigEndian<std::uint64_t>(p), out);
+                break;
+            case 0xd0:
+                fits = FitInteger(std::int64_t{LoadBigEndian<std::int8_t>(p)}, out);
+                break;
+            case 0xd1:
+                fits = FitInteger(std::int64_t{LoadBigEndian<std::int16_t>(p)}, out);
+                break;
+            case 0xd2:
+                fits = FitInteger(std::int64_t{LoadBigEndian<std::int32_t>(p)}, out);
+                break;
+            default:
+                fits = FitInteger(LoadBigEndian<std::int64_t>(p), out);
+                break;
+        }
+        if (fits) {
+            in += 1 + size;
+        }
+        return fits;
+    }
+}
+
+/** Decode up to `count` numbers from raw MessagePack data, see `DecodeNumber`.
+ *
+ * @return The number of values decoded, `in` points past the last one.
+ */
+template <typename T>
+std::size_t DecodeNumbers(const char*& in, const char* end, T* out, std::size_t count) {
+    std::size_t i{0};
+    while (i < count && DecodeNumber(in, end, out[i])) {
+        ++i;
+    }
+    return i;
+}
+
+/** Copy numbers from the parsed children of an array node.
+ *
+ * Like `DecodeNumber`, only exact type matches and in range integers are accepted.
+ * The loop has no early exit so it stays simple enough to vectorize.
+ *
+ * @return false if any of the elements needs the generic mpack conversion.
+ */
+template <typename T>
+bool CopyNodeNumbers(const mpack_node_data_t* children, T* out, std::size_t count) {
+    bool ok{true};
+    if constexpr (std::is_same_v<T, float>) {
+        for (std::size_t i{0}; i < count; ++i) {
+            ok &= children[i].type == mpack_type_float;
+            out[i] = children[i].value.f;
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        for (std::size_t i{0}; i < count; ++i) {
+            ok &= children[i].type == mpack_type_double;
+            out[i] = children[i].value.d;
+        }
+    } else {
+        for (std::size_t i{0}; i < count; ++i) {
+            const auto& child = children[i];
+            if (child.type == mpack_type_uint) {
+                ok &= FitInteger(child.value.u, out[i]);
+            } else if (child.type == mpack_type_int) {
+                ok &= FitInteger(child.value.i, out[i]);
+            } else {
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+}  // namespace internal
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_BULK_HPP_
@@ -1,9 +1,13 @@
 #ifndef MPACK_CPP__MPACK_EXPECT_READER_HPP_
 #define MPACK_CPP__MPACK_EXPECT_READER_HPP_
 
+#include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <istream>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -13,11 +17,99 @@
 #include <vector>
 
 #include "mpack.h"  //  NOLINT
+#include "mpack_cpp/mpack_bulk.hpp"
+#include "mpack_cpp/mpack_stats.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
 
 namespace mpack_cpp {
 namespace expect {
+
+/** Upper bounds on the sizes accepted while decoding.
+ *
+ * The reader allocates destination containers before reading their elements, so
+ * these limits protect against huge allocations triggered by malformed input.
+ */
+struct ReadLimits {
+    std::uint32_t max_array_size{std::uint32_t{1} << 26};
+    std::uint32_t max_map_size{std::uint32_t{1} << 20};
+    std::uint32_t max_str_size{std::uint32_t{1} << 30};
+    /** Bytes of a 'bin', see `Packed`. */
+    std::uint32_t max_bin_size{std::uint32_t{1} << 30};
+};
+
+/** Source of streamed input, see `ReadFromMsgPack`.
+ *
+ * Copies at most `count` bytes into `buffer` and returns the number of bytes
+ * copied. Returning 0 signals the end of the input, `kFillError` a read error.
+ */
+using FillFunction = std::function<std::size_t(char* buffer, std::size_t count)>;
+
+/** Returned by a `FillFunction` when the input could not be read. */
+constexpr std::size_t kFillError{SIZE_MAX};
+
 namespace internal {
 
+/** State shared with the decoders through the mpack reader context. */
+struct ReaderContext {
+    ReadLimits limits;
+    /** Entries left in the map being decoded, used to detect absent optionals. */
+    std::size_t map_entries{SIZE_MAX};
+    /** Input of a streaming reader. */
+    const FillFunction* fill{nullptr};
+    /** Bytes returned by `fill` so far. */
+    std::size_t filled{0};
+};
+
+inline ReaderContext* GetContext(mpack_reader_t& reader) {
+    return static_cast<ReaderContext*>(mpack_reader_context(&reader));
+}
+
+inline const ReadLimits& GetLimits(mpack_reader_t& reader) {
+    static const ReadLimits kDefaultLimits{};
+    auto* context = GetContext(reader);
+    return context != nullptr ? context->limits : kDefaultLimits;
+}
+
+inline std::size_t FillFromContext(mpack_reader_t* reader, char* buffer,
+                                   std::size_t count) {
+    std::size_t n = (*GetContext(*reader)->fill)(buffer, count);
+    if (n == kFillError) {
+        mpack_reader_flag_error(reader, mpack_error_io);
+        return 0;
+    }
+    GetContext(*reader)->filled += n;
+    return n;
+}
+
+/** Count the bytes a streaming reader decoded, of `buffered` and all it filled.
+ *
+ * Bytes still in the buffer belong to the next message, or are discarded.
+ */
+inline void AddConsumedBytes(mpack_reader_t& reader, std::size_t buffered,
+                             std::size_t remaining) {
+    const std::size_t total = buffered + GetContext(reader)->filled;
+    mpack_cpp::internal::AddStat(&CallStats::bytes_in, total - remaining);
+}
+
+#if __has_include(<unistd.h>)
+/** Fill from a blocking file descriptor, a non-blocking one that would block is a
+ * read error.
+ */
+inline FillFunction FillFromFile(FileDescriptor file) {
+    return [file](char* buffer, std::size_t count) -> std::size_t {
+        ssize_t n;
+        do {
+            n = ::read(file.fd, buffer, count);
+        } while (n < 0 && errno == EINTR);
+        return n >= 0 ? static_cast<std::size_t>(n) : kFillError;
+    };
+}
+#endif
+
 template <typename T, typename... Args>
 void read_and_assign(std::variant<Args...>& variant, T (*reader_func)(mpack_reader_t*),
                      mpack_reader_t* reader) {
@@ -65,9 +157,10 @@ struct ReadVisitor {
      */
     template <typename CharT, typename Traits, typename Allocator>
     void operator()(std::basic_string<CharT, Traits, Allocator>& value) {
-        uint32_t length = mpack_expect_str(&reader);
-        value.resize(static_cast<std::size_t>(length));
-        mpack_read_cstr(&reader, value.data(), 100, value.size());
+        uint32_t length = mpack_expect_str_max(&reader, GetLimits(reader).max_str_size);
+        mpack_cpp::internal::TrackGrowth(
+            value, [&] { value.resize(static_cast<std::size_t>(length)); });
+        mpack_read_bytes(&reader, value.data(), value.size());
         mpack_done_str(&reader);
     }
 
@@ -76,14 +169,64 @@ struct ReadVisitor {
      */
     template <typename ElemT, typename Allocator>
     void operator()(std::vector<ElemT, Allocator>& vec) {
-        std::size_t count = mpack_expect_array_max(&reader, 100);
-        vec.resize(count);
-        for (std::size_t i{0}; i < count; ++i) {
-            (*this)(vec[i]);
-        }
+        std::size_t count =
+            mpack_expect_array_max(&reader, GetLimits(reader).max_array_size);
+        mpack_cpp::internal::TrackGrowth(vec, [&] { vec.resize(count); });
+        ReadArray(vec.data(), count);
+        mpack_done_array(&reader);
+    }
+
+    /** Decode a fixed size array, the MessagePack array must have N elements. */
+    template <typename ElemT, std::size_t N>
+    void operator()(std::array<ElemT, N>& arr) {
+        mpack_expect_array_match(&reader, static_cast<std::uint32_t>(N));
+        ReadArray(arr.data(), N);
         mpack_done_array(&reader);
     }
 
+    /** Decode the elements of an array, numbers are decoded in bulk.
+     *
+     * Numbers are decoded straight from the reader's buffer. Elements that are not
+     * completely buffered yet, or need a conversion, go through mpack.
+     */
+    template <typename ElemT>
+    void ReadArray(ElemT* data, std::size_t count) {
+        std::size_t i{0};
+        while (i < count && mpack_reader_error(&reader) == mpack_ok) {
+            if constexpr (mpack_cpp::internal::IsBulkNumber<ElemT>::value &&
+                          !mpack_cpp::internal::kReadTracking) {
+                i += mpack_cpp::internal::DecodeNumbers(reader.data, reader.end, data + i,
+                                                        count - i);
+                if (i == count) {
+                    break;
+                }
+            }
+            (*this)(data[i++]);
+        }
+    }
+
+    /** Decode numbers stored as a single little-endian 'bin', see `Packed`. */
+    template <typename ContainerT>
+    void operator()(Packed<ContainerT> packed) {
+        using ElemT = typename ContainerT::value_type;
+        static_assert(mpack_cpp::internal::IsBulkNumber<ElemT>::value,
+                      "Packed requires a container of numbers.");
+        std::size_t size = mpack_expect_bin_max(&reader, GetLimits(reader).max_bin_size);
+        if (size % sizeof(ElemT) != 0) {
+            mpack_reader_flag_error(&reader, mpack_error_type);
+            return;
+        }
+        packed.values.resize(size / sizeof(ElemT));
+        auto* data = reinterpret_cast<char*>(packed.values.data());
+        mpack_read_bytes(&reader, data, size);
+        // In place, one byte elements have no byte order.
+        if constexpr (!mpack_cpp::internal::kLittleEndian && sizeof(ElemT) > 1) {
+            auto count = packed.values.size();
+            mpack_cpp::internal::CopyLittleEndian<ElemT>(data, data, count);
+        }
+        mpack_done_bin(&reader);
+    }
+
     /** Decode a pair from a fixed length array, two element, MessagePack array. */
     template <typename FirstT, typename SecondT>
     void operator()(std::pair<FirstT, SecondT>& pair) {
@@ -126,10 +269,19 @@ struct ReadVisitor {
     // template<typename T, std::enable_if<has_from_message_pack_v<T>, int> = 0>
     template <typename T>
     void operator()(T& value) {
-        std::size_t n = mpack_expect_map_max(&reader, 30);
+        std::size_t n = mpack_expect_map_max(&reader, GetLimits(reader).max_map_size);
+        auto* context = GetContext(reader);
+        std::size_t outer_entries{0};
+        if (context != nullptr) {
+            outer_entries = context->map_entries;
+            context->map_entries = n;
+        }
         if (n > 0) {
             value.from_message_pack(reader);
         }
+        if (context != nullptr) {
+            context->map_entries = outer_entries;
+        }
         mpack_done_map(&reader);
     }
 };
@@ -142,6 +294,17 @@ struct ReadVisitor {
  * */
 using ReadCtx = mpack_reader_t;
 
+namespace internal {
+/** Read the key of the next map entry and count the entry as consumed. */
+inline void ExpectKey(mpack_reader_t& reader, const char* key) {
+    mpack_expect_cstr_match(&reader, key);
+    auto* context = GetContext(reader);
+    if (context != nullptr && context->map_entries > 0) {
+        --context->map_entries;
+    }
+}
+}  // namespace internal
+
 /** Generic key-value decoder for 'simple' types.
  *
  * For 'complex' types use the corresponding specialized version:
@@ -150,14 +313,14 @@ using ReadCtx = mpack_reader_t;
  */
 template <typename T>
 void ReadField(ReadCtx& reader, const char* key, T&& value) {
-    mpack_expect_cstr_match(&reader, key);
+    internal::ExpectKey(reader, key);
     internal::ReadVisitor{reader}(std::forward<T>(value));
 }
 
 template <std::size_t N>
 void ReadExtField(ReadCtx& reader, const char* key, std::int8_t& type,
                   std::array<char, N>& data) {
-    mpack_expect_cstr_match(&reader, key);
+    internal::ExpectKey(reader, key);
     auto n =
         mpack_expect_ext_max(&reader, &type, static_cast<std::uint32_t>(data.size()));
     if (n != data.size()) {
@@ -178,6 +341,17 @@ inline std::uint8_t GetFixStrLength(const char c) {
     // Extract last 5 bits as uint8.
     return static_cast<std::uint8_t>(c) & static_cast<uint8_t>(~0xe0);
 }
+
+/** Make sure `count` bytes can be peeked at, pulling them from the input if needed. */
+inline bool EnsureBuffered(mpack_reader_t& reader, std::size_t count) {
+    if (static_cast<std::size_t>(reader.end - reader.data) >= count) {
+        return true;
+    }
+    if (reader.fill == nullptr || mpack_reader_error(&reader) != mpack_ok) {
+        return false;
+    }
+    return mpack_reader_ensure(&reader, count);
+}
 }  // namespace internal
 
 /** Decode optional fields.
@@ -188,6 +362,11 @@ inline std::uint8_t GetFixStrLength(const char c) {
 template <typename T>
 void ReadOptionalField(ReadCtx& reader, const char* key, T&& value) {
     value = std::nullopt;
+    auto* context = internal::GetContext(reader);
+    if ((context != nullptr && context->map_entries == 0) ||
+        !internal::EnsureBuffered(reader, 1)) {
+        return;
+    }
     if (!internal::IsFixStr(reader.data[0])) {
         // TODO(jeroendm) support arbitrary sized strings.
         // TODO(jeroendm) we cannot set the error flag here
@@ -200,6 +379,9 @@ void ReadOptionalField(ReadCtx& reader, const char* key, T&& value) {
     }
 
     auto length = internal::GetFixStrLength(reader.data[0]);
+    if (!internal::EnsureBuffered(reader, std::size_t{1} + length)) {
+        return;
+    }
     const std::string key_s(key, strlen(key));
     const std::string next_key_s(reader.data + 1, length);
     if (key_s != next_key_s) {
@@ -210,11 +392,8 @@ void ReadOptionalField(ReadCtx& reader, const char* key, T&& value) {
     ReadField(reader, key, value.value());
 }
 
-template <typename T>
-bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size) {
-    mpack_reader_t reader;
-    mpack_reader_init_data(&reader, buffer_start, msg_size);
-    internal::ReadVisitor{reader}(data);
+namespace internal {
+inline bool Finish(mpack_reader_t& reader) {
     auto err = mpack_reader_destroy(&reader);
     if (err != mpack_ok) {
         fprintf(stderr, "An error occurred decoding the data!\n");
@@ -226,21 +405,185 @@ bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size) {
 }
 
 template <typename T>
-bool ReadFromMsgPack(T& msg, const std::uint8_t* buffer_start, std::size_t msg_size) {
-    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer_start), msg_size);
+bool Decode(mpack_reader_t& reader, T& data) {
+    ReadVisitor{reader}(data);
+    return Finish(reader);
+}
+}  // namespace internal
+
+template <typename T>
+bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size,
+                     const ReadLimits& limits = ReadLimits{}) {
+    mpack_cpp::internal::StatsScope<T> stats(CallStats::Operation::kDecode);
+    mpack_cpp::internal::AddStat(&CallStats::bytes_in, msg_size);
+    internal::ReaderContext context{limits};
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, buffer_start, msg_size);
+    mpack_reader_set_context(&reader, &context);
+    return internal::Decode(reader, data);
 }
 
 template <typename T>
-bool ReadFromMsgPack(T& msg, const std::vector<char>& buffer, std::size_t msg_size) {
-    return ReadFromMsgPack(msg, buffer.data(), msg_size);
+bool ReadFromMsgPack(T& msg, const std::uint8_t* buffer_start, std::size_t msg_size,
+                     const ReadLimits& limits = ReadLimits{}) {
+    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer_start), msg_size,
+                           limits);
+}
+
+template <typename T>
+bool ReadFromMsgPack(T& msg, const std::vector<char>& buffer, std::size_t msg_size,
+                     const ReadLimits& limits = ReadLimits{}) {
+    return ReadFromMsgPack(msg, buffer.data(), msg_size, limits);
 }
 
 template <typename T>
 bool ReadFromMsgPack(T& msg, const std::vector<std::uint8_t>& buffer,
-                     std::size_t msg_size) {
-    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer.data()), msg_size);
+                     std::size_t msg_size, const ReadLimits& limits = ReadLimits{}) {
+    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer.data()), msg_size,
+                           limits);
+}
+
+/** Decode a message from streamed input.
+ *
+ * The input is pulled through a buffer of `buffer_size` bytes while decoding, so
+ * memory use does not depend on the message size. The buffer may hold bytes past
+ * the end of the message, these are discarded. Use a `StreamReader` to decode
+ * messages written back-to-back.
+ */
+template <typename T>
+bool ReadFromMsgPack(T& data, const FillFunction& fill,
+                     const ReadLimits& limits = ReadLimits{},
+                     std::size_t buffer_size = kStreamBufferSize) {
+    mpack_cpp::internal::StatsScope<T> stats(CallStats::Operation::kDecode);
+    internal::ReaderContext context{limits};
+    context.fill = &fill;
+    std::vector<char> buffer(
+        std::max<std::size_t>(buffer_size, MPACK_READER_MINIMUM_BUFFER_SIZE));
+    mpack_reader_t reader;
+    mpack_reader_init(&reader, buffer.data(), buffer.size(), 0);
+    mpack_reader_set_context(&reader, &context);
+    mpack_reader_set_fill(&reader, internal::FillFromContext);
+    internal::ReadVisitor{reader}(data);
+    internal::AddConsumedBytes(reader, 0, mpack_reader_remaining(&reader, nullptr));
+    return internal::Finish(reader);
 }
 
+/** Decode a message from a stream, bytes past the end of the message are lost. */
+template <typename T>
+bool ReadFromMsgPack(T& data, std::istream& stream,
+                     const ReadLimits& limits = ReadLimits{},
+                     std::size_t buffer_size = kStreamBufferSize) {
+    FillFunction fill = [&stream](char* buffer, std::size_t count) -> std::size_t {
+        return static_cast<std::size_t>(
+            stream.rdbuf()->sgetn(buffer, static_cast<std::streamsize>(count)));
+    };
+    return ReadFromMsgPack(data, fill, limits, buffer_size);
+}
+
+#if __has_include(<unistd.h>)
+/** Decode a message from a blocking file descriptor, bytes past the end of the
+ * message are lost.
+ */
+template <typename T>
+bool ReadFromMsgPack(T& data, FileDescriptor file,
+                     const ReadLimits& limits = ReadLimits{},
+                     std::size_t buffer_size = kStreamBufferSize) {
+    return ReadFromMsgPack(data, internal::FillFromFile(file), limits, buffer_size);
+}
+#endif
+
+/** Decoder for consecutive messages on streamed input.
+ *
+ * Like the streaming `ReadFromMsgPack`, but bytes buffered past the end of a
+ * message are kept for the next call, so messages written back-to-back can be
+ * decoded one after the other:
+ *
+ * ```
+ * mpack_cpp::expect::StreamReader stream(input);
+ * while (stream.Read(msg)) {
+ *     Handle(msg);
+ * }
+ * ```
+ *
+ * `Read` returns false without an error message when the input ends cleanly
+ * between two messages, `eof()` tells that apart from an error. After an error the
+ * position in the input is lost and the buffered bytes are dropped.
+ */
+class StreamReader {
+   public:
+    explicit StreamReader(FillFunction fill, const ReadLimits& limits = ReadLimits{},
+                          std::size_t buffer_size = kStreamBufferSize)
+        : fill_(std::move(fill)),
+          limits_(limits),
+          buffer_(std::max<std::size_t>(buffer_size, MPACK_READER_MINIMUM_BUFFER_SIZE)) {}
+
+    explicit StreamReader(std::istream& stream, const ReadLimits& limits = ReadLimits{},
+                          std::size_t buffer_size = kStreamBufferSize)
+        : StreamReader(
+              [&stream](char* buffer, std::size_t count) -> std::size_t {
+                  return static_cast<std::size_t>(stream.rdbuf()->sgetn(
+                      buffer, static_cast<std::streamsize>(count)));
+              },
+              limits, buffer_size) {}
+
+#if __has_include(<unistd.h>)
+    /** Reader for a blocking file descriptor, see `ReadFromMsgPack`. */
+    explicit StreamReader(FileDescriptor file, const ReadLimits& limits = ReadLimits{},
+                          std::size_t buffer_size = kStreamBufferSize)
+        : StreamReader(internal::FillFromFile(file), limits, buffer_size) {}
+#endif
+
+    /** Decode the next message, false at the end of the input or on an error. */
+    template <typename T>
+    bool Read(T& data) {
+        if (buffered_ == 0) {
+            // Only the first byte of a message tells a clean end from a truncation.
+            std::size_t n = fill_(buffer_.data(), buffer_.size());
+            if (n == kFillError) {
+                fprintf(stderr, "An error occurred decoding the data!\n");
+                fprintf(stderr, "%s!\n", mpack_error_to_string(mpack_error_io));
+                return false;
+            }
+            eof_ = n == 0;
+            if (eof_) {
+                return false;
+            }
+            buffered_ = n;
+        }
+        mpack_cpp::internal::StatsScope<T> stats(CallStats::Operation::kDecode);
+        internal::ReaderContext context{limits_};
+        context.fill = &fill_;
+        mpack_reader_t reader;
+        mpack_reader_init(&reader, buffer_.data(), buffer_.size(), buffered_);
+        mpack_reader_set_context(&reader, &context);
+        mpack_reader_set_fill(&reader, internal::FillFromContext);
+        internal::ReadVisitor{reader}(data);
+
+        // Keep the bytes of the next messages at the start of the buffer.
+        const char* rest{nullptr};
+        const std::size_t start = buffered_;
+        buffered_ = mpack_reader_remaining(&reader, &rest);
+        internal::AddConsumedBytes(reader, start, buffered_);
+        if (buffered_ > 0) {
+            std::memmove(buffer_.data(), rest, buffered_);
+        }
+        return internal::Finish(reader);
+    }
+
+    /** Number of bytes read from the input that were not decoded yet. */
+    std::size_t buffered() const { return buffered_; }
+
+    /** True when the last `Read` found the end of the input between messages. */
+    bool eof() const { return eof_; }
+
+   private:
+    FillFunction fill_;
+    ReadLimits limits_;
+    std::vector<char> buffer_;
+    std::size_t buffered_{0};
+    bool eof_{false};
+};
+
 }  // namespace expect
 }  // namespace mpack_cpp
 
@@ -0,0 +1,334 @@
+#ifndef MPACK_CPP__MPACK_FRAMING_HPP_
+#define MPACK_CPP__MPACK_FRAMING_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "mpack_cpp/mpack_bulk.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+#if __has_include(<sys/uio.h>)
+#include <fcntl.h>
+#endif
+
+/** Length-prefixed framing of messages in a byte stream.
+ *
+ * Every frame is a length prefix followed by one encoded message. The prefix is
+ * either a 4 byte big-endian integer or an unsigned LEB128 varint of at most 5
+ * bytes. Varints may be padded with continuation bytes, which LEB128 decoders
+ * accept.
+ */
+
+namespace mpack_cpp {
+
+enum class FramePrefix {
+    kFixed32,  // 4 byte big-endian length.
+    kVarint,   // LEB128 length, 1 to 5 bytes.
+};
+
+namespace internal {
+
+constexpr std::size_t kMaxVarintSize{5};
+
+struct EncodedPrefix {
+    std::array<char, kMaxVarintSize> data{};
+    std::size_t size{0};
+};
+
+/** Number of bytes of the shortest LEB128 encoding of `length`. */
+constexpr std::size_t VarintSize(std::uint64_t length) {
+    std::size_t size{1};
+    while (length >= 0x80) {
+        length >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/** Encode a length prefix, a varint is padded to at least `min_size` bytes. */
+inline EncodedPrefix EncodePrefix(FramePrefix prefix, std::uint32_t length,
+                                  std::size_t min_size = 1) {
+    EncodedPrefix out{};
+    if (prefix == FramePrefix::kFixed32) {
+        StoreBigEndian(out.data.data(), length);
+        out.size = 4;
+    } else {
+        do {
+            auto byte = static_cast<std::uint8_t>(length & 0x7f);
+            length >>= 7;
+            const bool more = length > 0 || out.size + 1 < min_size;
+            out.data[out.size++] = static_cast<char>(more ? byte | 0x80 : byte);
+        } while (length > 0 || out.size < min_size);
+    }
+    return out;
+}
+
+/** The prefix holds 32 bits, larger messages can not be framed. */
+inline bool CheckFrameLength(std::size_t length) {
+    if (length > std::numeric_limits<std::uint32_t>::max()) {
+        fprintf(stderr, "Message of %zu bytes is too large for a frame!\n", length);
+        return false;
+    }
+    return true;
+}
+
+/** Prefix size reserved in front of an encoded `T`.
+ *
+ * The varint width follows from the compile-time size bound of `T` when it has
+ * one, and is the maximum width otherwise.
+ */
+template <typename T>
+constexpr std::size_t ReservedPrefixSize(FramePrefix prefix) {
+    if (prefix == FramePrefix::kFixed32) {
+        return 4;
+    }
+    constexpr std::size_t kBound = MaxSize<T>::value;
+    if constexpr (kBound <= std::numeric_limits<std::uint32_t>::max()) {
+        return VarintSize(kBound);
+    } else {
+        return kMaxVarintSize;
+    }
+}
+
+}  // namespace internal
+
+/** Encode `data` as one frame appended to a growable container.
+ *
+ * The message is encoded right behind the space reserved for the prefix, and the
+ * prefix is written into that space afterwards, so the message is never copied.
+ * A varint prefix takes the width of the compile-time size bound of `T` (see
+ * `MaxEncodedSize`), types without a bound get a padded 5 byte varint.
+ *
+ * @return The size of the frame, or 0 on error, including messages over 4 GiB.
+ */
+template <typename T, typename ContainerT>
+std::size_t WriteFrame(const T& data, GrowableBuffer<ContainerT> sink,
+                       FramePrefix prefix = FramePrefix::kFixed32) {
+    const std::size_t offset = sink.container.size();
+    const std::size_t reserved = internal::ReservedPrefixSize<T>(prefix);
+    sink.container.resize(offset + reserved);
+    std::size_t n = WriteToMsgPack(data, sink);
+    if (n == 0 || !internal::CheckFrameLength(n)) {
+        sink.container.resize(offset);
+        return 0;
+    }
+
+    auto encoded =
+        internal::EncodePrefix(prefix, static_cast<std::uint32_t>(n), reserved);
+    char* frame = reinterpret_cast<char*>(sink.container.data()) + offset;
+    std::memcpy(frame, encoded.data.data(), encoded.size);
+    return encoded.size + n;
+}
+
+#if __has_include(<sys/uio.h>)
+/** Encode `data` as one frame and write it to a file descriptor.
+ *
+ * The message is encoded in `scratch`, which is reused between calls, and written
+ * together with the prefix by a single `writev`, without copying them together.
+ *
+ * The file descriptor must be blocking: a partial write to a non-blocking one
+ * would leave half a frame in the stream, so those are refused before anything
+ * is written. On non-blocking sockets write frames into a container and send it
+ * from there.
+ *
+ * @return The size of the frame, or 0 on error, including messages over 4 GiB.
+ */
+template <typename T>
+std::size_t WriteFrame(const T& data, FileDescriptor file, std::vector<char>& scratch,
+                       FramePrefix prefix = FramePrefix::kFixed32) {
+    const int flags = ::fcntl(file.fd, F_GETFL);
+    if (flags < 0 || (flags & O_NONBLOCK) != 0) {
+        fprintf(stderr, "Frames can only be written to a blocking file descriptor!\n");
+        return 0;
+    }
+    scratch.clear();
+    std::size_t n = WriteToMsgPack(data, GrowableBuffer{scratch});
+    if (n == 0 || !internal::CheckFrameLength(n)) {
+        return 0;
+    }
+    auto encoded = internal::EncodePrefix(prefix, static_cast<std::uint32_t>(n));
+    std::vector<iovec> buffers{{encoded.data.data(), encoded.size},
+                               {scratch.data(), scratch.size()}};
+    if (!internal::WriteAll(file.fd, buffers)) {
+        fprintf(stderr, "An error occurred writing the frame!\n");
+        fprintf(stderr, "%s!\n", std::strerror(errno));
+        return 0;
+    }
+    return encoded.size + n;
+}
+#endif
+
+/** Incremental decoder that splits a byte stream into frames.
+ *
+ * Bytes are added as they arrive, with `Feed` or `ReadFrom`, and `Next` hands out
+ * every complete frame as a view on the internal buffer. The view stays valid
+ * until the next call to `Feed` or `ReadFrom`, and plugs straight into the
+ * decode functions:
+ *
+ * ```
+ * mpack_cpp::FrameDecoder frames;
+ * frames.ReadFrom(mpack_cpp::FileDescriptor{socket});
+ * mpack_cpp::BytesView frame;
+ * while (frames.Next(frame)) {
+ *     mpack_cpp::ReadFromMsgPack(msg, frame.data, frame.size);
+ * }
+ * ```
+ */
+class FrameDecoder {
+   public:
+    /** Result of reading from a file descriptor. */
+    enum class Status {
+        kOpen,    // All available bytes were read, more may follow.
+        kFull,    // A frame of the maximum size is buffered, take frames first.
+        kClosed,  // The other side closed the stream.
+        kError,   // Reading failed, see errno.
+    };
+
+    static constexpr std::size_t kDefaultMaxFrameSize{std::size_t{64} << 20};
+
+    explicit FrameDecoder(FramePrefix prefix = FramePrefix::kFixed32,
+                          std::size_t max_frame_size = kDefaultMaxFrameSize)
+        : prefix_(prefix), max_frame_size_(max_frame_size) {}
+
+    /** Add received bytes. */
+    void Feed(const char* data, std::size_t size) {
+        if (size == 0) {
+            return;
+        }
+        std::memcpy(Reserve(size), data, size);
+        end_ += size;
+    }
+
+#if __has_include(<unistd.h>)
+    /** Read the bytes that are available on a (non-blocking) file descriptor.
+     *
+     * Reading stops once the unreturned bytes could hold a frame of the maximum
+     * size, so a peer cannot make the buffer grow without bound. Take the frames
+     * with `Next` and read again after `Status::kFull`.
+     */
+    Status ReadFrom(FileDescriptor file, std::size_t chunk_size = kStreamBufferSize) {
+        const std::size_t limit = max_frame_size_ + internal::kMaxVarintSize;
+        while (true) {
+            if (buffered() >= limit) {
+                return Status::kFull;
+            }
+            const std::size_t count = std::min(chunk_size, limit - buffered());
+            char* out = Reserve(count);
+            ssize_t n = ::read(file.fd, out, count);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK ? Status::kOpen
+                                                               : Status::kError;
+            }
+            if (n == 0) {
+                return Status::kClosed;
+            }
+            end_ += static_cast<std::size_t>(n);
+            if (static_cast<std::size_t>(n) < count) {
+                return Status::kOpen;
+            }
+        }
+    }
+#endif
+
+    /** Take the next complete frame, returns false when it is not complete yet.
+     *
+     * A frame larger than the maximum frame size or a malformed prefix puts the
+     * decoder in an error state, in which no more frames are returned.
+     */
+    bool Next(BytesView& frame) {
+        if (error_) {
+            return false;
+        }
+        std::size_t prefix_size{0};
+        std::uint64_t length{0};
+        if (!ParsePrefix(prefix_size, length)) {
+            return false;
+        }
+        if (length > max_frame_size_) {
+            fprintf(stderr, "Frame of %llu bytes exceeds the maximum frame size!\n",
+                    static_cast<unsigned long long>(length));
+            error_ = true;
+            return false;
+        }
+        if (end_ - begin_ < prefix_size + length) {
+            return false;
+        }
+        frame = BytesView{buffer_.data() + begin_ + prefix_size,
+                          static_cast<std::size_t>(length)};
+        begin_ += prefix_size + static_cast<std::size_t>(length);
+        return true;
+    }
+
+    /** True after a malformed or oversized frame. */
+    bool error() const { return error_; }
+
+    /** Number of received bytes that are not part of a returned frame. */
+    std::size_t buffered() const { return end_ - begin_; }
+
+   private:
+    bool ParsePrefix(std::size_t& prefix_size, std::uint64_t& length) {
+        const char* in = buffer_.data() + begin_;
+        const std::size_t available = end_ - begin_;
+        if (prefix_ == FramePrefix::kFixed32) {
+            if (available < 4) {
+                return false;
+            }
+            prefix_size = 4;
+            length = internal::LoadBigEndian<std::uint32_t>(in);
+            return true;
+        }
+        for (std::size_t i{0}; i < internal::kMaxVarintSize; ++i) {
+            if (i == available) {
+                return false;
+            }
+            auto byte = static_cast<std::uint8_t>(in[i]);
+            length |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * i);
+            if ((byte & 0x80) == 0) {
+                prefix_size = i + 1;
+                return true;
+            }
+        }
+        fprintf(stderr, "Malformed frame length prefix!\n");
+        error_ = true;
+        return false;
+    }
+
+    /** Room for `size` more bytes at the end, returned frames are invalidated. */
+    char* Reserve(std::size_t size) {
+        if (begin_ > 0) {
+            // Drop the bytes of returned frames.
+            std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (buffer_.size() < end_ + size) {
+            buffer_.resize(std::max(end_ + size, buffer_.size() * 2));
+        }
+        return buffer_.data() + end_;
+    }
+
+    FramePrefix prefix_;
+    std::size_t max_frame_size_;
+    std::vector<char> buffer_;
+    std::size_t begin_{0};  // Start of the first frame that was not returned yet.
+    std::size_t end_{0};    // End of the received bytes.
+    bool error_{false};
+};
+
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_FRAMING_HPP_
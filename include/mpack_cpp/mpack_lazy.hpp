@@ -0,0 +1,291 @@
+#ifndef MPACK_CPP__MPACK_LAZY_HPP_
+#define MPACK_CPP__MPACK_LAZY_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_scan.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+
+/** On-demand access to single members of an encoded message.
+ *
+ * `ReadFromMsgPack` parses the complete message and decodes every member. When
+ * only a few members are needed, a `LazyView` finds them by skip-scanning the
+ * encoded map and decodes nothing else:
+ *
+ * ```
+ * mpack_cpp::LazyView<Order> order(frame.data, frame.size);
+ * std::string symbol;
+ * if (order.Read<&Order::symbol>(symbol) && symbol == "ACME") {
+ *     order.Read<&Order::price>(price);
+ * }
+ * ```
+ */
+
+namespace mpack_cpp {
+
+/** How a `LazyView` locates members. */
+enum class LazyIndex {
+    kCached,  // Index the offsets of all members on first access.
+    kNone,    // Scan the map up to the member on every access, never allocates.
+};
+
+/** Result of looking up a member in a `LazyView`. */
+enum class LazyFind {
+    kFound,
+    kMissing,    // The map is well-formed but has no such key.
+    kMalformed,  // The buffer is not a complete map.
+};
+
+namespace internal {
+
+template <typename T>
+struct MemberPointer;
+
+template <typename T, typename C>
+struct MemberPointer<T C::*> {
+    using Class = C;
+    using Type = T;
+};
+
+/** Key of a member and its position in `message_pack_fields()`. */
+struct FieldInfo {
+    std::string_view key;
+    std::size_t index{0};
+};
+
+template <typename FieldT, typename T, typename C>
+constexpr void MatchField(const FieldT& field, T C::*member, std::size_t index,
+                          FieldInfo& info) {
+    if constexpr (std::is_same_v<decltype(field.member), T C::*>) {
+        if (field.member == member) {
+            info = FieldInfo{field.key, index};
+        }
+    }
+}
+
+/** Look up a member in the field list generated by `MPACK_CPP_DEFINE`. */
+template <typename C, typename T>
+constexpr FieldInfo FindField(T C::*member) {
+    FieldInfo info{};
+    std::size_t index{0};
+    std::apply(
+        [&](const auto&... fields) { (MatchField(fields, member, index++, info), ...); },
+        C::message_pack_fields());
+    return info;
+}
+
+}  // namespace internal
+
+/** View on an encoded struct that decodes its members on demand.
+ *
+ * Members are located by skip-scanning the map headers, only the requested value
+ * is parsed and decoded. With `LazyIndex::kCached` the first access records the
+ * offsets of all members, so later accesses skip the scan entirely.
+ *
+ * Members are selected by member pointer, which is checked at compile time, for
+ * structs declared with `MPACK_CPP_DEFINE`. Any map can be accessed by key.
+ *
+ * The view does not own the buffer, it must outlive the view. A view is not
+ * thread-safe because of the cached index, use one view per thread.
+ */
+template <typename T>
+class LazyView {
+   public:
+    LazyView() = default;
+
+    LazyView(const char* data, std::size_t size, LazyIndex index = LazyIndex::kCached)
+        : data_(data), size_(size), index_(index) {}
+
+    explicit LazyView(BytesView bytes, LazyIndex index = LazyIndex::kCached)
+        : LazyView(bytes.data, bytes.size, index) {}
+
+    /** Decode a single member.
+     *
+     * A missing `std::optional` member is reset to `std::nullopt`, any other
+     * missing member is an error. A malformed buffer is always an error.
+     */
+    template <auto Member>
+    bool Read(typename internal::MemberPointer<decltype(Member)>::Type& out,
+              std::pmr::memory_resource* resource = nullptr) {
+        static constexpr auto kField = FindMember<Member>();
+        BytesView value;
+        return ReadValue(Find(kField.key, value, kField.index), value, out, resource);
+    }
+
+    /** View on a member that is itself a struct, without decoding it.
+     *
+     * The nested view shares the indexing mode. When the member is missing, the
+     * returned view is empty and every read from it fails.
+     */
+    template <auto Member>
+    auto View() {
+        using MemberT = typename internal::MemberPointer<decltype(Member)>::Type;
+        static constexpr auto kField = FindMember<Member>();
+        BytesView value;
+        if (Find(kField.key, value, kField.index) != LazyFind::kFound) {
+            return LazyView<MemberT>(BytesView{}, index_);
+        }
+        return LazyView<MemberT>(value, index_);
+    }
+
+    /** Decode the value of `key`, missing keys are handled like missing members. */
+    template <typename ValueT>
+    bool Read(std::string_view key, ValueT& out,
+              std::pmr::memory_resource* resource = nullptr) {
+        BytesView value;
+        return ReadValue(Find(key, value), value, out, resource);
+    }
+
+    /** Find the encoded value of `key`, without decoding it.
+     *
+     * `value` points into the buffer, so it can be forwarded or decoded later.
+     * Messages written by the same struct have their keys in declaration order, so
+     * `hint` (the position in the map) is checked first when the index is cached.
+     * `value` is only set when the key is found.
+     */
+    LazyFind Find(std::string_view key, BytesView& value, std::size_t hint = 0) {
+        if (malformed_) {
+            return LazyFind::kMalformed;
+        }
+        if (index_ == LazyIndex::kNone) {
+            return Scan(key, &value, false);
+        }
+        if (!indexed_ && Scan({}, nullptr, true) == LazyFind::kMalformed) {
+            return LazyFind::kMalformed;
+        }
+        if (hint < entries_.size() && entries_[hint].key == key) {
+            value = entries_[hint].value;
+            return LazyFind::kFound;
+        }
+        for (const auto& entry : entries_) {
+            if (entry.key == key) {
+                value = entry.value;
+                return LazyFind::kFound;
+            }
+        }
+        return LazyFind::kMissing;
+    }
+
+    /** True when the buffer is a well-formed map, scans it completely.
+     *
+     * With `LazyIndex::kCached` the scan builds the index, otherwise it records
+     * nothing.
+     */
+    bool valid() {
+        const bool index = index_ == LazyIndex::kCached;
+        return indexed_ || (!malformed_ && Scan({}, nullptr, index) == LazyFind::kFound);
+    }
+
+   private:
+    struct Entry {
+        std::string_view key;
+        BytesView value;
+    };
+
+    template <auto Member>
+    static constexpr internal::FieldInfo FindMember() {
+        using Pointer = internal::MemberPointer<decltype(Member)>;
+        static_assert(std::is_same_v<typename Pointer::Class, T>,
+                      "Expected a member pointer of the viewed struct.");
+        constexpr auto field = internal::FindField(Member);
+        static_assert(!field.key.empty(), "Member is not listed in MPACK_CPP_DEFINE.");
+        return field;
+    }
+
+    /** Walk the map until `key` is found, or to its end when `value` is null.
+     *
+     * Non-string keys are skipped. Walking to the end returns `kFound` once the
+     * whole map is scanned, and records all entries when `index` is set.
+     */
+    LazyFind Scan(std::string_view key, BytesView* value, bool index) {
+        std::uint32_t count{0};
+        std::size_t pos = internal::ScanMapHeader(data_, size_, count);
+        if (pos == 0) {
+            return Malformed();
+        }
+        if (index) {
+            // Every entry takes at least 2 bytes, do not trust the count blindly.
+            entries_.clear();
+            entries_.reserve(std::min<std::size_t>(count, (size_ - pos) / 2));
+        }
+        for (std::uint32_t i{0}; i < count; ++i) {
+            std::string_view entry_key;
+            std::size_t n = internal::ScanStr(data_ + pos, size_ - pos, entry_key);
+            const bool is_str = n != 0;
+            if (!is_str) {
+                n = internal::ScanObject(data_ + pos, size_ - pos);
+                if (n == 0) {
+                    return Malformed();
+                }
+            }
+            pos += n;
+            n = internal::ScanObject(data_ + pos, size_ - pos);
+            if (n == 0) {
+                return Malformed();
+            }
+            if (is_str && index) {
+                entries_.push_back({entry_key, BytesView{data_ + pos, n}});
+            } else if (is_str && value != nullptr && entry_key == key) {
+                *value = BytesView{data_ + pos, n};
+                return LazyFind::kFound;
+            }
+            pos += n;
+        }
+        indexed_ = index;
+        return value == nullptr ? LazyFind::kFound : LazyFind::kMissing;
+    }
+
+    /** The buffer does not change, so later lookups fail without scanning again. */
+    LazyFind Malformed() {
+        malformed_ = true;
+        entries_.clear();
+        return LazyFind::kMalformed;
+    }
+
+    /** Decode a looked up value, errors are returned and not logged. */
+    template <typename ValueT>
+    static bool ReadValue(LazyFind found, BytesView value, ValueT& out,
+                          std::pmr::memory_resource* resource) {
+        if (found == LazyFind::kFound) {
+            return Decode(value, out, resource);
+        }
+        if constexpr (internal::IsOptional<ValueT>::value) {
+            if (found == LazyFind::kMissing) {
+                out.reset();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename ValueT>
+    static bool Decode(BytesView value, ValueT& out,
+                       std::pmr::memory_resource* resource) {
+        if constexpr (internal::IsOptional<ValueT>::value) {
+            internal::EmplaceWithResource(out, resource);
+            return internal::DecodeTree(out.value(), value.data, value.size,
+                                        resource) == mpack_ok;
+        } else {
+            return internal::DecodeTree(out, value.data, value.size, resource) ==
+                   mpack_ok;
+        }
+    }
+
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    LazyIndex index_{LazyIndex::kCached};
+    std::vector<Entry> entries_;
+    bool indexed_{false};
+    bool malformed_{false};
+};
+
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_LAZY_HPP_
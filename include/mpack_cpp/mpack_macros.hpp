@@ -4,33 +4,77 @@
 #include "boost/preprocessor.hpp"
 
 // Each macro takes 3 parameters (r, data, elem) as required by BOOST_PP_SEQ_FOR_EACH
-#define MPACK_WRITE_FIELD_OP(r, writer, field) \
-    mpack_cpp::WriteField(writer, BOOST_PP_STRINGIZE(field), field);
-
-#define MPACK_READ_FIELD_OP(r, node, field) \
-    mpack_cpp::ReadField(node, BOOST_PP_STRINGIZE(field), field);
+#define MPACK_WRITE_FIELD_OP(r, writer, field)               \
+    {                                                        \
+        static constexpr auto kMpackCppKey =                 \
+            mpack_cpp::EncodeKey(BOOST_PP_STRINGIZE(field)); \
+        mpack_cpp::WriteField(writer, kMpackCppKey, field);  \
+    }
 
 #define MPACK_EXPECT_READ_FIELD_OP(r, reader, field) \
     mpack_cpp::expect::ReadField(reader, BOOST_PP_STRINGIZE(field), field);
 
-#define MPACK_CPP_DEFINE(Type, ...)                                  \
-    void to_message_pack(mpack_cpp::WriteCtx& writer) const {        \
-        BOOST_PP_SEQ_FOR_EACH(MPACK_WRITE_FIELD_OP, writer,          \
-                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) \
-    }                                                                \
-    void from_message_pack(mpack_cpp::ReadCtx& node) {               \
-        BOOST_PP_SEQ_FOR_EACH(MPACK_READ_FIELD_OP, node,             \
-                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) \
+#define MPACK_COUNT_FIELD_OP(r, data, field) + mpack_cpp::internal::FieldCount(field)
+
+// Takes 3 parameters (s, data, elem) as required by BOOST_PP_SEQ_TRANSFORM
+#define MPACK_KEY_OP(s, data, field) BOOST_PP_STRINGIZE(field)
+
+#define MPACK_MAX_SIZE_OP(s, Type, field)                     \
+    mpack_cpp::internal::MaxFieldSize<decltype(Type::field)>( \
+        sizeof(BOOST_PP_STRINGIZE(field)) - 1)
+
+#define MPACK_FIELD_KEY_OP(s, Type, field) \
+    mpack_cpp::internal::MakeFieldKey(BOOST_PP_STRINGIZE(field), &Type::field)
+
+#define MPACK_CPP_DEFINE(Type, ...)                                              \
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {                    \
+        BOOST_PP_SEQ_FOR_EACH(MPACK_WRITE_FIELD_OP, writer,                      \
+                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))             \
+    }                                                                            \
+    std::uint32_t message_pack_map_size() const {                                \
+        return 0 BOOST_PP_SEQ_FOR_EACH(MPACK_COUNT_FIELD_OP, _,                  \
+                                       BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__));   \
+    }                                                                            \
+    static constexpr std::size_t message_pack_max_size() {                       \
+        return mpack_cpp::internal::MaxMapSize(BOOST_PP_SEQ_ENUM(                \
+            BOOST_PP_SEQ_TRANSFORM(MPACK_MAX_SIZE_OP, Type,                      \
+                                   BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))));     \
+    }                                                                            \
+    static constexpr auto message_pack_fields() {                                \
+        return std::make_tuple(BOOST_PP_SEQ_ENUM(                                \
+            BOOST_PP_SEQ_TRANSFORM(MPACK_FIELD_KEY_OP, Type,                     \
+                                   BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))));     \
+    }                                                                            \
+    void from_message_pack(mpack_cpp::ReadCtx& node) {                           \
+        static constexpr auto kMpackCppKeys = mpack_cpp::internal::MakeKeyTable( \
+            std::array<std::string_view, BOOST_PP_VARIADIC_SIZE(__VA_ARGS__)>{   \
+                BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_TRANSFORM(                        \
+                    MPACK_KEY_OP, _, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)))});  \
+        mpack_cpp::ReadFields(node, kMpackCppKeys, __VA_ARGS__);                 \
     }
 
-#define MPACK_CPP_EXPECT_DEFINE(Type, ...)                           \
-    void to_message_pack(mpack_cpp::WriteCtx& writer) const {        \
-        BOOST_PP_SEQ_FOR_EACH(MPACK_WRITE_FIELD_OP, writer,          \
-                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) \
-    }                                                                \
-    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {     \
-        BOOST_PP_SEQ_FOR_EACH(MPACK_EXPECT_READ_FIELD_OP, reader,    \
-                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) \
+#define MPACK_CPP_EXPECT_DEFINE(Type, ...)                                     \
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {                  \
+        BOOST_PP_SEQ_FOR_EACH(MPACK_WRITE_FIELD_OP, writer,                    \
+                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))           \
+    }                                                                          \
+    std::uint32_t message_pack_map_size() const {                              \
+        return 0 BOOST_PP_SEQ_FOR_EACH(MPACK_COUNT_FIELD_OP, _,                \
+                                       BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)); \
+    }                                                                          \
+    static constexpr std::size_t message_pack_max_size() {                     \
+        return mpack_cpp::internal::MaxMapSize(BOOST_PP_SEQ_ENUM(              \
+            BOOST_PP_SEQ_TRANSFORM(MPACK_MAX_SIZE_OP, Type,                    \
+                                   BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))));   \
+    }                                                                          \
+    static constexpr auto message_pack_fields() {                              \
+        return std::make_tuple(BOOST_PP_SEQ_ENUM(                              \
+            BOOST_PP_SEQ_TRANSFORM(MPACK_FIELD_KEY_OP, Type,                   \
+                                   BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))));   \
+    }                                                                          \
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {               \
+        BOOST_PP_SEQ_FOR_EACH(MPACK_EXPECT_READ_FIELD_OP, reader,              \
+                              BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))           \
     }
 
 #endif
\ No newline at end of file
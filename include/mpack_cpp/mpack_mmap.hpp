@@ -0,0 +1,156 @@
+#ifndef MPACK_CPP__MPACK_MMAP_HPP_
+#define MPACK_CPP__MPACK_MMAP_HPP_
+
+/** Decoding from memory mapped files.
+ *
+ * Requires POSIX `mmap`, the header is empty otherwise.
+ */
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+
+#define MPACK_CPP_HAS_MMAP 1
+
+namespace mpack_cpp {
+
+/** Read-only memory mapping of a file with encoded MessagePack data.
+ *
+ * Decoding straight from the mapping avoids reading the file into a buffer first,
+ * and the data is not duplicated next to the page cache. Zero-copy fields, like
+ * `std::string_view`, point into the mapping and stay valid as long as the
+ * `MappedMsgPackFile` is alive.
+ *
+ * ```
+ * mpack_cpp::MappedMsgPackFile file("archive.msgpack");
+ * if (file.is_open()) {
+ *     mpack_cpp::ReadFromMsgPack(archive, file);
+ * }
+ * ```
+ */
+class MappedMsgPackFile {
+   public:
+    /** Expected access pattern, passed on to the kernel as `madvise` hint. */
+    enum class Access { kSequential, kRandom };
+
+    MappedMsgPackFile() = default;
+
+    explicit MappedMsgPackFile(const std::string& path,
+                               Access access = Access::kSequential) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            PrintError("open", path);
+            return;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            PrintError("fstat", path);
+            ::close(fd);
+            return;
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                PrintError("mmap", path);
+                size_ = 0;
+                ::close(fd);
+                return;
+            }
+            ::madvise(mapping, size_,
+                      access == Access::kSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            data_ = static_cast<const char*>(mapping);
+        }
+        // The mapping keeps the file alive on its own.
+        ::close(fd);
+        is_open_ = true;
+    }
+
+    MappedMsgPackFile(const MappedMsgPackFile&) = delete;
+    MappedMsgPackFile& operator=(const MappedMsgPackFile&) = delete;
+
+    MappedMsgPackFile(MappedMsgPackFile&& other) noexcept { *this = std::move(other); }
+
+    MappedMsgPackFile& operator=(MappedMsgPackFile&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            is_open_ = std::exchange(other.is_open_, false);
+        }
+        return *this;
+    }
+
+    ~MappedMsgPackFile() { Unmap(); }
+
+    /** False when the file could not be opened or mapped. */
+    bool is_open() const { return is_open_; }
+
+    /** Start of the mapped data, `nullptr` for empty or unopened files. */
+    const char* data() const { return data_; }
+
+    std::size_t size() const { return size_; }
+
+   private:
+    static void PrintError(const char* call, const std::string& path) {
+        fprintf(stderr, "Could not map '%s', %s failed!\n", path.c_str(), call);
+        fprintf(stderr, "%s!\n", std::strerror(errno));
+    }
+
+    void Unmap() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        is_open_ = false;
+    }
+
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    bool is_open_{false};
+};
+
+/** Decode a message from a mapped file, see `MappedMsgPackFile`. */
+template <typename T>
+bool ReadFromMsgPack(T& data, const MappedMsgPackFile& file,
+                     std::pmr::memory_resource* resource = nullptr) {
+    if (file.data() == nullptr) {
+        fprintf(stderr, "There is no mapped data to decode!\n");
+        return false;
+    }
+    return ReadFromMsgPack(data, file.data(), file.size(), resource);
+}
+
+namespace expect {
+
+/** Decode a message from a mapped file, see `MappedMsgPackFile`. */
+template <typename T>
+bool ReadFromMsgPack(T& data, const MappedMsgPackFile& file,
+                     const ReadLimits& limits = ReadLimits{}) {
+    if (file.data() == nullptr) {
+        fprintf(stderr, "There is no mapped data to decode!\n");
+        return false;
+    }
+    return ReadFromMsgPack(data, file.data(), file.size(), limits);
+}
+
+}  // namespace expect
+}  // namespace mpack_cpp
+
+#endif  // __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+
+#endif  //  MPACK_CPP__MPACK_MMAP_HPP_
@@ -0,0 +1,382 @@
+#ifndef MPACK_CPP__MPACK_PARALLEL_HPP_
+#define MPACK_CPP__MPACK_PARALLEL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "mpack_cpp/mpack_bulk.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_scan.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace mpack_cpp {
+namespace internal {
+
+/** Number of threads to use for `count` work items, 0 requests one per core. */
+inline std::size_t ThreadCount(std::size_t num_threads, std::size_t count) {
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return std::max<std::size_t>(std::min(num_threads, count), 1);
+}
+
+/** Joins the started threads when leaving the scope, also by an exception. */
+struct JoinThreads {
+    std::vector<std::thread>& threads;
+
+    ~JoinThreads() {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+/** Run `work(thread_index, begin, end)` over `count` items split into contiguous
+ * ranges, one per thread. The calling thread takes the first range.
+ *
+ * All threads are joined before returning. When `work` throws, the first
+ * exception is rethrown on the calling thread afterwards.
+ */
+template <typename WorkT>
+void ParallelFor(std::size_t num_threads, std::size_t count, const WorkT& work) {
+    const std::size_t threads = ThreadCount(num_threads, count);
+    const std::size_t chunk = (count + threads - 1) / threads;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run = [&](std::size_t t, std::size_t begin, std::size_t end) noexcept {
+        try {
+            work(t, begin, end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+    {
+        std::vector<std::thread> workers;
+        JoinThreads join{workers};
+        workers.reserve(threads - 1);
+        for (std::size_t t{1}; t < threads; ++t) {
+            std::size_t begin = std::min(t * chunk, count);
+            std::size_t end = std::min(begin + chunk, count);
+            workers.emplace_back([&run, t, begin, end] { run(t, begin, end); });
+        }
+        run(std::size_t{0}, std::size_t{0}, std::min(chunk, count));
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/** Find the start of every message in back-to-back encoded messages.
+ *
+ * `offsets` receives one entry per message plus the end of the last message.
+ */
+inline bool ScanMessages(const char* data, std::size_t size,
+                         std::vector<std::size_t>& offsets) {
+    offsets.clear();
+    std::size_t pos{0};
+    while (pos < size) {
+        offsets.push_back(pos);
+        std::size_t n = ScanObject(data + pos, size - pos);
+        if (n == 0) {
+            return false;
+        }
+        pos += n;
+    }
+    offsets.push_back(pos);
+    return true;
+}
+
+}  // namespace internal
+
+/** One memory arena per decoding thread, for `ParallelReadFromMsgPack`.
+ *
+ * Every thread decodes into its own `std::pmr::monotonic_buffer_resource`, so the
+ * threads do not contend on a shared allocator. The decoded items allocate from
+ * the arenas, which must outlive them. `Release` frees all arenas at once.
+ */
+class ThreadArenas {
+   public:
+    explicit ThreadArenas(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {}
+
+    /** Arena of thread `thread`, created on first use. */
+    std::pmr::memory_resource* Get(std::size_t thread) {
+        while (arenas_.size() <= thread) {
+            arenas_.push_back(
+                std::make_unique<std::pmr::monotonic_buffer_resource>(upstream_));
+        }
+        return arenas_[thread].get();
+    }
+
+    /** Number of arenas created so far. */
+    std::size_t size() const { return arenas_.size(); }
+
+    /** Free the memory of all arenas, items decoded into them become invalid. */
+    void Release() {
+        for (auto& arena : arenas_) {
+            arena->release();
+        }
+    }
+
+   private:
+    std::pmr::memory_resource* upstream_;
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas_;
+};
+
+namespace internal {
+
+/** Replace `out` by a default value constructed with uses-allocator construction.
+ *
+ * Allocator-aware types only, others are left alone. `out` is destroyed first, so
+ * a throwing constructor terminates instead of leaving a destroyed object behind.
+ */
+template <typename T>
+void ReconstructWithResource(T& out, std::pmr::memory_resource* resource) noexcept {
+    if constexpr (std::uses_allocator_v<T, ResourceAllocator>) {
+        out.~T();
+        if constexpr (std::is_constructible_v<T, std::allocator_arg_t,
+                                              const ResourceAllocator&>) {
+            ::new (static_cast<void*>(&out)) T(std::allocator_arg,
+                                               ResourceAllocator{resource});
+        } else {
+            ::new (static_cast<void*>(&out)) T(ResourceAllocator{resource});
+        }
+    }
+}
+
+template <typename T, typename AllocT>
+bool ParallelDecode(const char* data, std::size_t size, std::vector<T, AllocT>& items,
+                    std::size_t num_threads, ThreadArenas* arenas) {
+    std::vector<std::size_t> offsets;
+    if (!ScanMessages(data, size, offsets)) {
+        fprintf(stderr, "An error occurred decoding the data!\n");
+        fprintf(stderr, "Incomplete or invalid message at offset %zu!\n",
+                offsets.back());
+        return false;
+    }
+
+    const std::size_t count = offsets.size() - 1;
+    const std::size_t threads = ThreadCount(num_threads, count);
+    std::vector<std::pmr::memory_resource*> resources(threads, nullptr);
+    if (arenas != nullptr) {
+        for (std::size_t t{0}; t < threads; ++t) {
+            resources[t] = arenas->Get(t);
+        }
+    }
+    items.resize(count);
+    std::atomic<bool> success{true};
+    ParallelFor(threads, count, [&](std::size_t t, std::size_t begin, std::size_t end) {
+        Decoder decoder;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (resources[t] != nullptr) {
+                ReconstructWithResource(items[i], resources[t]);
+            }
+            if (!decoder.Read(items[i], data + offsets[i], offsets[i + 1] - offsets[i],
+                              resources[t])) {
+                success = false;
+                return;
+            }
+        }
+    });
+    return success;
+}
+
+}  // namespace internal
+
+/** Decode back-to-back messages, as written by `WriteBatch`, on several threads.
+ *
+ * The message boundaries are found first by skip-scanning the encoded data, which
+ * is much cheaper than parsing it. The messages are then split in contiguous
+ * ranges, one per thread, and each thread decodes its range with its own
+ * `Decoder`, so node pools are reused and never shared. The decoded items replace
+ * the content of `items`, in the order of the messages.
+ *
+ * @param num_threads Number of threads to use, 0 uses one thread per core.
+ */
+template <typename T, typename AllocT>
+bool ParallelReadFromMsgPack(const char* data, std::size_t size,
+                             std::vector<T, AllocT>& items,
+                             std::size_t num_threads = 0) {
+    return internal::ParallelDecode(data, size, items, num_threads, nullptr);
+}
+
+/** Decode on several threads, every thread allocating from its own arena.
+ *
+ * Thread `t` decodes into `arenas.Get(t)`, see `ReadFromMsgPack` for how the
+ * resource is used. Allocator-aware items are also constructed with the arena of
+ * their thread, replacing their previous value.
+ */
+template <typename T, typename AllocT>
+bool ParallelReadFromMsgPack(const char* data, std::size_t size,
+                             std::vector<T, AllocT>& items, ThreadArenas& arenas,
+                             std::size_t num_threads = 0) {
+    return internal::ParallelDecode(data, size, items, num_threads, &arenas);
+}
+
+template <typename T, typename AllocT, typename ByteT>
+bool ParallelReadFromMsgPack(const std::vector<ByteT>& buffer,
+                             std::vector<T, AllocT>& items,
+                             std::size_t num_threads = 0) {
+    static_assert(sizeof(ByteT) == 1, "ParallelReadFromMsgPack requires bytes.");
+    return ParallelReadFromMsgPack(reinterpret_cast<const char*>(buffer.data()),
+                                   buffer.size(), items, num_threads);
+}
+
+template <typename T, typename AllocT, typename ByteT>
+bool ParallelReadFromMsgPack(const std::vector<ByteT>& buffer,
+                             std::vector<T, AllocT>& items, ThreadArenas& arenas,
+                             std::size_t num_threads = 0) {
+    static_assert(sizeof(ByteT) == 1, "ParallelReadFromMsgPack requires bytes.");
+    return ParallelReadFromMsgPack(reinterpret_cast<const char*>(buffer.data()),
+                                   buffer.size(), items, arenas, num_threads);
+}
+
+namespace internal {
+
+/** Encoded array header, the same bytes `mpack_start_array` writes. */
+struct ArrayHeader {
+    std::array<char, 5> data{};
+    std::size_t size{0};
+};
+
+inline ArrayHeader EncodeArrayHeader(std::uint32_t count) {
+    ArrayHeader header{};
+    if (count <= 15) {
+        header.data[0] = static_cast<char>(0x90 | count);  // fixarray
+        header.size = 1;
+    } else if (count <= 0xffff) {
+        header.data[0] = static_cast<char>(0xdc);  // array16
+        StoreBigEndian(header.data.data() + 1, static_cast<std::uint16_t>(count));
+        header.size = 3;
+    } else {
+        header.data[0] = static_cast<char>(0xdd);  // array32
+        StoreBigEndian(header.data.data() + 1, count);
+        header.size = 5;
+    }
+    return header;
+}
+
+/** Contiguous part of an array, iterable by `WriteBatch`. */
+template <typename T>
+struct Shard {
+    const T* first;
+    const T* last;
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    std::size_t size() const { return static_cast<std::size_t>(last - first); }
+};
+
+/** Encode the elements of `items` without array header, in one buffer per thread.
+ *
+ * Elements are encoded independently of each other, so concatenating the shards
+ * gives the same bytes as encoding them in one go.
+ */
+template <typename T>
+bool EncodeShards(const T* items, std::size_t count, std::size_t num_threads,
+                  std::vector<std::vector<char>>& shards) {
+    shards.assign(ThreadCount(num_threads, count), {});
+    std::atomic<bool> success{true};
+    ParallelFor(shards.size(), count,
+                [&](std::size_t shard, std::size_t begin, std::size_t end) {
+                    if (begin == end) {
+                        return;
+                    }
+                    Shard<T> range{items + begin, items + end};
+                    if (WriteBatch(range, GrowableBuffer{shards[shard]}) == 0) {
+                        success = false;
+                    }
+                });
+    return success;
+}
+
+}  // namespace internal
+
+/** Encode a large array on several threads.
+ *
+ * The array is split in one shard per thread and every shard is encoded into its
+ * own buffer. The array header and the shards are then appended to the container.
+ * The output is identical to `WriteToMsgPack`.
+ *
+ * @param num_threads Number of threads to use, 0 uses one thread per core.
+ * @return The number of bytes appended to the container, or 0 on error.
+ */
+template <typename T, typename AllocT, typename ContainerT>
+std::size_t ParallelWriteToMsgPack(const std::vector<T, AllocT>& items,
+                                   GrowableBuffer<ContainerT> sink,
+                                   std::size_t num_threads = 0) {
+    std::vector<std::vector<char>> shards;
+    if (!internal::EncodeShards(items.data(), items.size(), num_threads, shards)) {
+        return 0;
+    }
+    auto header = internal::EncodeArrayHeader(static_cast<std::uint32_t>(items.size()));
+    std::size_t total = header.size;
+    for (const auto& shard : shards) {
+        total += shard.size();
+    }
+
+    const std::size_t offset = sink.container.size();
+    sink.container.resize(offset + total);
+    char* out = reinterpret_cast<char*>(sink.container.data()) + offset;
+    std::memcpy(out, header.data.data(), header.size);
+    out += header.size;
+    for (const auto& shard : shards) {
+        std::memcpy(out, shard.data(), shard.size());
+        out += shard.size();
+    }
+    return total;
+}
+
+#if __has_include(<sys/uio.h>)
+/** Encode a large array on several threads and write it to a file descriptor.
+ *
+ * Like the `GrowableBuffer` overload, but the array header and the shards are
+ * written with `writev`, without copying them together first.
+ *
+ * @return The number of bytes written, or 0 on error.
+ */
+template <typename T, typename AllocT>
+std::size_t ParallelWriteToMsgPack(const std::vector<T, AllocT>& items,
+                                   FileDescriptor file, std::size_t num_threads = 0) {
+    std::vector<std::vector<char>> shards;
+    if (!internal::EncodeShards(items.data(), items.size(), num_threads, shards)) {
+        return 0;
+    }
+    auto header = internal::EncodeArrayHeader(static_cast<std::uint32_t>(items.size()));
+    std::vector<iovec> buffers;
+    buffers.push_back({header.data.data(), header.size});
+    std::size_t total = header.size;
+    for (auto& shard : shards) {
+        buffers.push_back({shard.data(), shard.size()});
+        total += shard.size();
+    }
+    if (!internal::WriteAll(file.fd, buffers)) {
+        fprintf(stderr, "An error occurred encoding the data!\n");
+        fprintf(stderr, "%s!\n", std::strerror(errno));
+        return 0;
+    }
+    return total;
+}
+#endif
+
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_PARALLEL_HPP_
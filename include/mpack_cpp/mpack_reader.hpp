@@ -3,22 +3,95 @@
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "mpack.h"  //  NOLINT
+#include "mpack_cpp/mpack_bulk.hpp"
+#include "mpack_cpp/mpack_scan.hpp"
+#include "mpack_cpp/mpack_stats.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
 
 namespace mpack_cpp {
 
 namespace internal {
 
+/** State shared with the visitors through the mpack tree context. */
+struct TreeContext {
+    /** Resource for the objects created while decoding, null to use the defaults. */
+    std::pmr::memory_resource* resource{nullptr};
+};
+
+inline std::pmr::memory_resource* GetResource(mpack_node_t node) {
+    auto* context = static_cast<TreeContext*>(mpack_tree_context(node.tree));
+    return context != nullptr ? context->resource : nullptr;
+}
+
+using ResourceAllocator = std::pmr::polymorphic_allocator<char>;
+
+template <typename T>
+struct IsPolymorphicAllocator : std::false_type {};
+
+template <typename T>
+struct IsPolymorphicAllocator<std::pmr::polymorphic_allocator<T>> : std::true_type {};
+
+/** Construct the value of `out` with uses-allocator construction from `resource`.
+ *
+ * Types that are not allocator-aware, or a null resource, are default constructed.
+ */
+template <typename T>
+void EmplaceWithResource(std::optional<T>& out, std::pmr::memory_resource* resource) {
+    if constexpr (std::uses_allocator_v<T, ResourceAllocator>) {
+        if (resource != nullptr) {
+            if constexpr (std::is_constructible_v<T, std::allocator_arg_t,
+                                                  const ResourceAllocator&>) {
+                out.emplace(std::allocator_arg, ResourceAllocator{resource});
+            } else {
+                out.emplace(ResourceAllocator{resource});
+            }
+            return;
+        }
+    }
+    out.emplace();
+}
+
+/** Resize a vector, new allocator-aware elements are constructed from `resource`.
+ *
+ * A vector with a polymorphic allocator already passes its own resource on to new
+ * elements, for other vectors the elements are constructed one by one.
+ */
+template <typename T, typename Allocator>
+void ResizeWithResource(std::vector<T, Allocator>& out, std::size_t count,
+                        std::pmr::memory_resource* resource) {
+    if constexpr (!IsPolymorphicAllocator<Allocator>::value &&
+                  std::uses_allocator_v<T, ResourceAllocator>) {
+        if (resource != nullptr && count > out.size()) {
+            out.reserve(count);
+            std::optional<T> element;
+            while (out.size() < count) {
+                EmplaceWithResource(element, resource);
+                out.push_back(std::move(*element));
+            }
+            return;
+        }
+    }
+    out.resize(count);
+}
+
 template <typename T, typename... Args>
 void read_and_assign(std::variant<Args...>& variant, T (*node_func)(mpack_node_t),
                      mpack_node_t node) {
@@ -38,6 +111,9 @@ void read_and_assign(std::variant<Args...>& variant, T (*node_func)(mpack_node_t
  *   - `std::basic_string` (std::string, std::pmr::string, ...)
  *   - `std::vector`
  *
+ * Vector elements and optional values created while decoding get the memory
+ * resource passed to `ReadFromMsgPack` through uses-allocator construction.
+ *
  * TODO(jeroedm)?
  *  - std::map
  *  - std::unordered_map
@@ -67,23 +143,90 @@ struct ReadVisitor {
      */
     template <typename CharT, typename Traits, typename Allocator>
     void operator()(std::basic_string<CharT, Traits, Allocator>& out) {
-        out.resize(mpack_node_strlen(node) + 1);
-        mpack_node_copy_cstr(node, out.data(), out.size());
-        out.resize(mpack_node_strlen(node));
+        const char* str = mpack_node_str(node);
+        if (str != nullptr) {
+            TrackGrowth(out, [&] { out.assign(str, mpack_node_strlen(node)); });
+        } else {
+            out.clear();
+        }
     }
 
+    /** Zero-copy string decoding.
+     *
+     * The view points into the input buffer, which must outlive the decoded data.
+     */
+    void operator()(std::string_view& out) {
+        out = std::string_view(mpack_node_str(node), mpack_node_strlen(node));
+    }
+
+    /** Zero-copy decoding of 'bin' data, see `operator()(std::string_view&)`. */
+    void operator()(BytesView& out) {
+        out = BytesView{mpack_node_data(node), mpack_node_data_len(node)};
+    }
+
+#if defined(__cpp_lib_span)
+    /** Zero-copy decoding of 'str', 'bin' or 'ext' data, see `BytesView`. */
+    void operator()(std::span<const char>& out) {
+        out = std::span<const char>(mpack_node_data(node), mpack_node_data_len(node));
+    }
+#endif
+
     /** Decode any kind of vector with support for custom allocators
      * (e.g. std::pmr::vector),
      */
     template <typename T, typename Allocator>
     void operator()(std::vector<T, Allocator>& out) {
-        out.resize(mpack_node_array_length(node));
-        for (std::size_t i{0}; i < out.size(); ++i) {
+        TrackGrowth(out, [&] {
+            ResizeWithResource(out, mpack_node_array_length(node), GetResource(node));
+        });
+        ReadArray(out.data(), out.size());
+    }
+
+    /** Decode a fixed size array, the MessagePack array must have N elements. */
+    template <typename T, std::size_t N>
+    void operator()(std::array<T, N>& out) {
+        if (mpack_node_array_length(node) != N) {
+            mpack_node_flag_error(node, mpack_error_type);
+            return;
+        }
+        ReadArray(out.data(), N);
+    }
+
+    /** Decode the elements of an array node, numbers are copied in bulk.
+     *
+     * When all elements are numbers of the exact type, they are copied straight from
+     * the parsed nodes. Otherwise every element goes through mpack's conversions.
+     */
+    template <typename T>
+    void ReadArray(T* out, std::size_t count) {
+        if constexpr (IsBulkNumber<T>::value) {
+            if (count > 0 && mpack_node_error(node) == mpack_ok &&
+                CopyNodeNumbers(node.data->value.children, out, count)) {
+                return;
+            }
+        }
+        for (std::size_t i{0}; i < count; ++i) {
             auto nested_node = mpack_node_array_at(node, i);
             ReadVisitor{nested_node}(out[i]);
         }
     }
 
+    /** Decode numbers stored as a single little-endian 'bin', see `Packed`. */
+    template <typename ContainerT>
+    void operator()(Packed<ContainerT> packed) {
+        using ElemT = typename ContainerT::value_type;
+        static_assert(internal::IsBulkNumber<ElemT>::value,
+                      "Packed requires a container of numbers.");
+        if (mpack_node_type(node) != mpack_type_bin ||
+            mpack_node_data_len(node) % sizeof(ElemT) != 0) {
+            mpack_node_flag_error(node, mpack_error_type);
+            return;
+        }
+        packed.values.resize(mpack_node_data_len(node) / sizeof(ElemT));
+        internal::CopyLittleEndian<ElemT>(reinterpret_cast<char*>(packed.values.data()),
+                                          mpack_node_data(node), packed.values.size());
+    }
+
     /** Decode a pair from a fixed length array, two element, MessagePack array. */
     template <typename FirstT, typename SecondT>
     void operator()(std::pair<FirstT, SecondT>& pair) {
@@ -172,24 +315,180 @@ void ReadExtField(ReadCtx& node, const char* key, std::int8_t& type,
 /** Decode optional fields.  */
 template <typename T>
 void ReadOptionalField(ReadCtx& node, const char* key, T&& out) {
-    if (mpack_node_map_contains_cstr(node, key)) {
-        out.emplace();
-        auto opt_node = mpack_node_map_cstr(node, key);
+    auto opt_node = mpack_node_map_cstr_optional(node, key);
+    if (mpack_node_type(opt_node) != mpack_type_missing) {
+        internal::EmplaceWithResource(out, internal::GetResource(opt_node));
         internal::ReadVisitor{opt_node}(out.value());
     } else {
         out = std::nullopt;
     }
 }
 
+namespace internal {
+
+/** Compile-time key table of a struct, used to route map entries to members.
+ *
+ * `keys` holds the keys in declaration order, `sorted` the same keys sorted for
+ * binary search, and `fields` maps every sorted key back to its member index.
+ */
+template <std::size_t N>
+struct KeyTable {
+    std::array<std::string_view, N> keys;
+    std::array<std::string_view, N> sorted;
+    std::array<std::size_t, N> fields;
+
+    /** Return the member index for `key`, or N if it is not a member.
+     *
+     * Messages written by the same struct have their keys in declaration order,
+     * so `hint` (the position in the map) is checked first.
+     */
+    constexpr std::size_t Find(std::string_view key, std::size_t hint) const {
+        if (hint < N && keys[hint] == key) {
+            return hint;
+        }
+        std::size_t first{0};
+        std::size_t last{N};
+        while (first < last) {
+            std::size_t mid = first + (last - first) / 2;
+            if (sorted[mid] < key) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return (first < N && sorted[first] == key) ? fields[first] : N;
+    }
+};
+
+template <std::size_t N>
+constexpr KeyTable<N> MakeKeyTable(const std::array<std::string_view, N>& keys) {
+    KeyTable<N> table{keys, keys, {}};
+    for (std::size_t i{0}; i < N; ++i) {
+        table.fields[i] = i;
+    }
+    // Insertion sort, std::sort is not constexpr in C++17.
+    for (std::size_t i{1}; i < N; ++i) {
+        for (std::size_t j{i}; j > 0 && table.sorted[j] < table.sorted[j - 1]; --j) {
+            std::string_view key = table.sorted[j];
+            table.sorted[j] = table.sorted[j - 1];
+            table.sorted[j - 1] = key;
+            std::size_t field = table.fields[j];
+            table.fields[j] = table.fields[j - 1];
+            table.fields[j - 1] = field;
+        }
+    }
+    return table;
+}
+
 template <typename T>
-bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size) {
+void ReadMember(mpack_node_t node, void* member) {
+    auto& out = *static_cast<T*>(member);
+    if constexpr (IsOptional<T>::value) {
+        EmplaceWithResource(out, GetResource(node));
+        ReadVisitor{node}(out.value());
+    } else {
+        ReadVisitor{node}(out);
+    }
+}
+
+/** Reset a member that is not in the map, return false if it is required. */
+template <typename T>
+bool HandleMissingMember(void* member) {
+    if constexpr (IsOptional<T>::value) {
+        static_cast<T*>(member)->reset();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+}  // namespace internal
+
+/** Decode all members of a struct in a single pass over the map.
+ *
+ * Every key in the map is looked up in the compile-time `table` and its value is
+ * routed to the corresponding member. Unknown keys are ignored, like with
+ * `ReadField`. Missing `std::optional` members are reset to `std::nullopt`,
+ * other missing members and duplicate keys flag `mpack_error_data`.
+ *
+ * This is what `MPACK_CPP_DEFINE` generates, it avoids the map scan per member
+ * that `ReadField` does.
+ */
+template <std::size_t N, typename... Members>
+void ReadFields(ReadCtx node, const internal::KeyTable<N>& table, Members&... members) {
+    static_assert(sizeof...(Members) == N, "Expected one key for every member.");
+    using ReadFn = void (*)(mpack_node_t, void*);
+    using MissingFn = bool (*)(void*);
+    static constexpr std::array<ReadFn, N> readers{&internal::ReadMember<Members>...};
+    static constexpr std::array<MissingFn, N> missing_handlers{
+        &internal::HandleMissingMember<Members>...};
+    const std::array<void*, N> pointers{static_cast<void*>(&members)...};
+
+    std::array<bool, N> seen{};
+    std::size_t count = mpack_node_map_count(node);
+    for (std::size_t i{0}; i < count; ++i) {
+        auto key = mpack_node_map_key_at(node, i);
+        if (mpack_node_type(key) != mpack_type_str) {
+            continue;
+        }
+        std::string_view key_str(mpack_node_str(key), mpack_node_strlen(key));
+        auto field = table.Find(key_str, i);
+        if (field == N) {
+            continue;
+        }
+        if (seen[field]) {
+            mpack_node_flag_error(node, mpack_error_data);
+            return;
+        }
+        seen[field] = true;
+        readers[field](mpack_node_map_value_at(node, i), pointers[field]);
+    }
+
+    for (std::size_t i{0}; i < N; ++i) {
+        if (!seen[i] && !missing_handlers[i](pointers[i])) {
+            mpack_node_flag_error(node, mpack_error_data);
+        }
+    }
+}
+
+namespace internal {
+/** Decode a message without reporting errors, see `ReadFromMsgPack`. */
+template <typename T>
+mpack_error_t DecodeTree(T& data, const char* buffer_start, std::size_t msg_size,
+                         std::pmr::memory_resource* resource) {
+    StatsScope<T> stats(CallStats::Operation::kDecode);
+    AddStat(&CallStats::bytes_in, msg_size);
     mpack_tree_t tree;
     mpack_tree_init_data(&tree, buffer_start, msg_size);
-    // mpack_tree_init_pool(&tree, buffer.data(), n, pool.data(), pool.size());
+    TreeContext context{resource};
+    mpack_tree_set_context(&tree, &context);
     mpack_tree_parse(&tree);
+    AddStat(&CallStats::nodes, tree.node_count);
     mpack_node_t root = mpack_tree_root(&tree);
-    internal::ReadVisitor{root}(data);
-    auto err = mpack_tree_destroy(&tree);
+    ReadVisitor{root}(data);
+    return mpack_tree_destroy(&tree);
+}
+}  // namespace internal
+
+/** Decode a message from a buffer.
+ *
+ * When `resource` is given, the vector elements and optional values created while
+ * decoding are allocated from it, as long as they are allocator-aware. Construct
+ * `data` itself with the same resource to decode the whole message into an arena:
+ *
+ * ```
+ * std::pmr::monotonic_buffer_resource arena;
+ * Request request{&arena};
+ * mpack_cpp::ReadFromMsgPack(request, buffer, size, &arena);
+ * ```
+ *
+ * Structs opt in by declaring `allocator_type` and an allocator-extended
+ * constructor, exactly like for `std::pmr::vector`.
+ */
+template <typename T>
+bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size,
+                     std::pmr::memory_resource* resource = nullptr) {
+    auto err = internal::DecodeTree(data, buffer_start, msg_size, resource);
     if (err != mpack_ok) {
         fprintf(stderr, "An error occurred decoding the data!\n");
         fprintf(stderr, "%s!\n", mpack_error_to_string(err));
@@ -200,21 +499,365 @@ bool ReadFromMsgPack(T& data, const char* buffer_start, std::size_t msg_size) {
 }
 
 template <typename T>
-bool ReadFromMsgPack(T& msg, const std::uint8_t* buffer_start, std::size_t msg_size) {
-    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer_start), msg_size);
+bool ReadFromMsgPack(T& msg, const std::uint8_t* buffer_start, std::size_t msg_size,
+                     std::pmr::memory_resource* resource = nullptr) {
+    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer_start), msg_size,
+                           resource);
 }
 
 template <typename T>
-bool ReadFromMsgPack(T& msg, const std::vector<char>& buffer, std::size_t msg_size) {
-    return ReadFromMsgPack(msg, buffer.data(), msg_size);
+bool ReadFromMsgPack(T& msg, const std::vector<char>& buffer, std::size_t msg_size,
+                     std::pmr::memory_resource* resource = nullptr) {
+    return ReadFromMsgPack(msg, buffer.data(), msg_size, resource);
 }
 
 template <typename T>
 bool ReadFromMsgPack(T& msg, const std::vector<std::uint8_t>& buffer,
-                     std::size_t msg_size) {
-    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer.data()), msg_size);
+                     std::size_t msg_size,
+                     std::pmr::memory_resource* resource = nullptr) {
+    return ReadFromMsgPack(msg, reinterpret_cast<const char*>(buffer.data()), msg_size,
+                           resource);
 }
 
+namespace internal {
+/** Offsets of the elements of the array at the start of `data`. */
+inline bool ScanArrayOffsets(const char* data, std::size_t size,
+                             std::vector<std::size_t>& offsets) {
+    std::uint32_t count{0};
+    std::size_t pos = ScanArrayHeader(data, size, count);
+    if (pos == 0) {
+        return false;
+    }
+    offsets.reserve(count);
+    for (std::uint32_t i{0}; i < count; ++i) {
+        offsets.push_back(pos);
+        std::size_t n = ScanObject(data + pos, size - pos);
+        if (n == 0) {
+            return false;
+        }
+        pos += n;
+    }
+    return true;
+}
+}  // namespace internal
+
+/** Decode a batch of messages written by `WriteBatch` with a single node tree.
+ *
+ * The decoded items replace the content of `items`, existing items are reused.
+ * When `offsets` is given, it receives the position of every item relative to the
+ * start of the batch.
+ */
+template <typename T, typename AllocT>
+bool ReadBatch(const char* data, std::size_t size, std::vector<T, AllocT>& items,
+               BatchFormat format = BatchFormat::kConcatenated,
+               std::vector<std::size_t>* offsets = nullptr) {
+    internal::StatsScope<std::vector<T, AllocT>> stats(CallStats::Operation::kDecode);
+    internal::AddStat(&CallStats::bytes_in, size);
+    if (offsets != nullptr) {
+        offsets->clear();
+    }
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, data, size);
+    if (format == BatchFormat::kArray) {
+        mpack_tree_parse(&tree);
+        internal::AddStat(&CallStats::nodes, tree.node_count);
+        internal::ReadVisitor{mpack_tree_root(&tree)}(items);
+        if (offsets != nullptr && !internal::ScanArrayOffsets(data, size, *offsets)) {
+            mpack_tree_flag_error(&tree, mpack_error_invalid);
+        }
+    } else {
+        // Every parse continues with the message after the previous one.
+        std::size_t count{0};
+        std::size_t position{0};
+        while (position < size && mpack_tree_error(&tree) == mpack_ok) {
+            mpack_tree_parse(&tree);
+            if (mpack_tree_error(&tree) != mpack_ok) {
+                break;
+            }
+            internal::AddStat(&CallStats::nodes, tree.node_count);
+            if (count == items.size()) {
+                items.emplace_back();
+            }
+            internal::ReadVisitor{mpack_tree_root(&tree)}(items[count++]);
+            if (offsets != nullptr) {
+                offsets->push_back(position);
+            }
+            position += mpack_tree_size(&tree);
+        }
+        items.resize(count);
+    }
+    auto err = mpack_tree_destroy(&tree);
+    if (err != mpack_ok) {
+        fprintf(stderr, "An error occurred decoding the data!\n");
+        fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+template <typename T, typename AllocT, typename ByteT>
+bool ReadBatch(const std::vector<ByteT>& buffer, std::vector<T, AllocT>& items,
+               BatchFormat format = BatchFormat::kConcatenated,
+               std::vector<std::size_t>* offsets = nullptr) {
+    static_assert(sizeof(ByteT) == 1, "ReadBatch requires a buffer of bytes.");
+    return ReadBatch(reinterpret_cast<const char*>(buffer.data()), buffer.size(), items,
+                     format, offsets);
+}
+
+/** Reusable decoder that owns the node pool used to parse messages.
+ *
+ * `ReadFromMsgPack` lets mpack allocate a new node tree for every message.
+ * A `Decoder` parses into a pool of nodes that is kept between messages, so
+ * decoding a stream of messages does not allocate once the pool is large enough.
+ * The pool only grows, by doubling, when a message needs more nodes than it has.
+ *
+ * ```
+ * mpack_cpp::Decoder decoder;
+ * for (const auto& msg : messages) {
+ *     decoder.Read(data, msg.data(), msg.size());
+ * }
+ * ```
+ */
+class Decoder {
+   public:
+    static constexpr std::size_t kDefaultPoolSize{256};
+
+    explicit Decoder(std::size_t pool_size = kDefaultPoolSize)
+        : pool_(std::max<std::size_t>(pool_size, 1)) {}
+
+    /** Decode a message, see `ReadFromMsgPack` for the use of `resource`. */
+    template <typename T>
+    bool Read(T& data, const char* buffer_start, std::size_t msg_size,
+              std::pmr::memory_resource* resource = nullptr) {
+        internal::StatsScope<T> stats(CallStats::Operation::kDecode);
+        internal::AddStat(&CallStats::bytes_in, msg_size);
+        mpack_tree_t tree;
+        internal::TreeContext context{resource};
+        Parse(tree, buffer_start, msg_size, context);
+        if (mpack_tree_error(&tree) == mpack_ok) {
+            internal::ReadVisitor{mpack_tree_root(&tree)}(data);
+        }
+        auto err = mpack_tree_destroy(&tree);
+        if (err != mpack_ok) {
+            fprintf(stderr, "An error occurred decoding the data!\n");
+            fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+            return false;
+        } else {
+            return true;
+        }
+    }
+
+    template <typename T>
+    bool Read(T& msg, const std::uint8_t* buffer_start, std::size_t msg_size,
+              std::pmr::memory_resource* resource = nullptr) {
+        return Read(msg, reinterpret_cast<const char*>(buffer_start), msg_size,
+                    resource);
+    }
+
+    template <typename T>
+    bool Read(T& msg, const std::vector<char>& buffer, std::size_t msg_size,
+              std::pmr::memory_resource* resource = nullptr) {
+        return Read(msg, buffer.data(), msg_size, resource);
+    }
+
+    template <typename T>
+    bool Read(T& msg, const std::vector<std::uint8_t>& buffer, std::size_t msg_size,
+              std::pmr::memory_resource* resource = nullptr) {
+        return Read(msg, reinterpret_cast<const char*>(buffer.data()), msg_size,
+                    resource);
+    }
+
+    /** Number of nodes currently in the pool. */
+    std::size_t pool_size() const { return pool_.size(); }
+
+    /** Largest number of nodes used by any message decoded so far. */
+    std::size_t high_water_mark() const { return high_water_mark_; }
+
+   private:
+    /** Parse into the pool, growing it until the message fits.
+     *
+     * Every MessagePack object takes at least one byte, so a message never needs
+     * more nodes than it has bytes. That bounds the number of retries.
+     */
+    void Parse(mpack_tree_t& tree, const char* buffer_start, std::size_t msg_size,
+               internal::TreeContext& context) {
+        const std::size_t max_nodes = std::max<std::size_t>(msg_size, 1);
+        while (true) {
+            mpack_tree_init_pool(&tree, buffer_start, msg_size, pool_.data(),
+                                 pool_.size());
+            mpack_tree_set_context(&tree, &context);
+            mpack_tree_parse(&tree);
+            if (mpack_tree_error(&tree) != mpack_error_too_big ||
+                pool_.size() >= max_nodes) {
+                break;
+            }
+            mpack_tree_destroy(&tree);
+            pool_.resize(std::min(pool_.size() * 2, max_nodes));
+            internal::AddStat(&CallStats::pool_growths, 1);
+        }
+        if (mpack_tree_error(&tree) == mpack_ok) {
+            internal::AddStat(&CallStats::nodes, tree.node_count);
+            high_water_mark_ = std::max(high_water_mark_, tree.node_count);
+        }
+    }
+
+    std::vector<mpack_node_data_t> pool_;
+    std::size_t high_water_mark_{0};
+};
+
+/** Resumable decoder for messages that arrive piece by piece.
+ *
+ * Built on `mpack_tree_try_parse`: every call to `TryRead` parses the bytes that
+ * arrived since the previous call and continues where it stopped, nothing is
+ * scanned twice. Input is either pushed with `Feed` or pulled from a non-blocking
+ * file descriptor, so it fits in an event loop:
+ *
+ * ```
+ * mpack_cpp::StreamDecoder decoder(mpack_cpp::FileDescriptor{socket});
+ * // When the socket is readable:
+ * while (decoder.TryRead(msg) == mpack_cpp::StreamDecoder::Status::kComplete) {
+ *     Handle(msg);
+ * }
+ * ```
+ *
+ * Fed bytes are borrowed, not copied: the parser copies them once into its own
+ * stream buffer, which holds the current message and whatever followed it in the
+ * last read. Zero-copy fields point into that buffer and are only valid until the
+ * next call to `TryRead`. After an error the decoder cannot be used anymore.
+ */
+class StreamDecoder : private internal::TreeContext {
+   public:
+    enum class Status {
+        kIncomplete,  // More data is needed to complete the message.
+        kComplete,    // A message was decoded.
+        kError,       // The input is invalid or could not be read.
+    };
+
+    static constexpr std::size_t kDefaultMaxMessageSize{std::size_t{64} << 20};
+    static constexpr std::size_t kDefaultMaxMessageNodes{std::size_t{1} << 20};
+
+    /** Decoder for input that is pushed with `Feed`. */
+    explicit StreamDecoder(std::size_t max_message_size = kDefaultMaxMessageSize,
+                           std::size_t max_message_nodes = kDefaultMaxMessageNodes) {
+        mpack_tree_init_stream(&tree_, ReadFromPending, AsContext(), max_message_size,
+                               max_message_nodes);
+    }
+
+#if __has_include(<unistd.h>)
+    /** Decoder that reads its input from a non-blocking file descriptor. */
+    explicit StreamDecoder(FileDescriptor file,
+                           std::size_t max_message_size = kDefaultMaxMessageSize,
+                           std::size_t max_message_nodes = kDefaultMaxMessageNodes)
+        : file_(file) {
+        mpack_tree_init_stream(&tree_, ReadFromFile, AsContext(), max_message_size,
+                               max_message_nodes);
+    }
+#endif
+
+    // The tree refers to this object, so it can not be copied or moved.
+    StreamDecoder(const StreamDecoder&) = delete;
+    StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+    ~StreamDecoder() { mpack_tree_destroy(&tree_); }
+
+    /** Hand received bytes to the parser, they are consumed by `TryRead`.
+     *
+     * The bytes are not copied here, they must stay valid until `TryRead` returns
+     * `kIncomplete` (or `kError`), which means all of them were consumed. Call
+     * `TryRead` until then before feeding more, otherwise this returns false.
+     */
+    bool Feed(const char* data, std::size_t size) {
+        if (pending_size_ != 0) {
+            fprintf(stderr, "The previously fed bytes were not consumed yet!\n");
+            return false;
+        }
+        pending_ = data;
+        pending_size_ = size;
+        return true;
+    }
+
+    /** Number of fed bytes that were not handed to the parser yet. */
+    std::size_t buffered() const { return pending_size_; }
+
+    /** Continue parsing and decode the message into `data` once it is complete. */
+    template <typename T>
+    Status TryRead(T& data) {
+        if (!mpack_tree_try_parse(&tree_)) {
+            return ReportError() ? Status::kError : Status::kIncomplete;
+        }
+        // Only complete messages are recorded, parsing the last piece included.
+        internal::StatsScope<T> stats(CallStats::Operation::kDecode);
+        internal::AddStat(&CallStats::bytes_in, mpack_tree_size(&tree_));
+        internal::AddStat(&CallStats::nodes, tree_.node_count);
+        internal::ReadVisitor{mpack_tree_root(&tree_)}(data);
+        return ReportError() ? Status::kError : Status::kComplete;
+    }
+
+    /** Allocate the objects created while decoding from `resource`, see
+     * `ReadFromMsgPack`.
+     */
+    void set_memory_resource(std::pmr::memory_resource* memory_resource) {
+        resource = memory_resource;
+    }
+
+   private:
+    // The tree context is the `TreeContext` base, shared with the visitors.
+    internal::TreeContext* AsContext() { return this; }
+
+    static StreamDecoder& FromContext(mpack_tree_t* tree) {
+        return *static_cast<StreamDecoder*>(
+            static_cast<internal::TreeContext*>(mpack_tree_context(tree)));
+    }
+
+    bool ReportError() {
+        auto err = mpack_tree_error(&tree_);
+        if (err == mpack_ok) {
+            return false;
+        }
+        fprintf(stderr, "An error occurred decoding the data!\n");
+        fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+        return true;
+    }
+
+    static std::size_t ReadFromPending(mpack_tree_t* tree, char* buffer,
+                                       std::size_t count) {
+        auto& self = FromContext(tree);
+        std::size_t n = std::min(count, self.pending_size_);
+        if (n != 0) {
+            std::memcpy(buffer, self.pending_, n);
+            self.pending_ += n;
+            self.pending_size_ -= n;
+        }
+        return n;
+    }
+
+#if __has_include(<unistd.h>)
+    static std::size_t ReadFromFile(mpack_tree_t* tree, char* buffer, std::size_t count) {
+        auto& self = FromContext(tree);
+        while (true) {
+            ssize_t n = ::read(self.file_.fd, buffer, count);
+            if (n > 0) {
+                return static_cast<std::size_t>(n);
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return 0;  // Suspends the parse until more data arrives.
+            }
+            mpack_tree_flag_error(tree, n == 0 ? mpack_error_eof : mpack_error_io);
+            return 0;
+        }
+    }
+#endif
+
+    mpack_tree_t tree_;
+    FileDescriptor file_{};
+    const char* pending_{nullptr};
+    std::size_t pending_size_{0};
+};
+
 }  // namespace mpack_cpp
 
 #endif  //  MPACK_CPP__MPACK_READER_HPP_
@@ -0,0 +1,448 @@
+#ifndef MPACK_CPP__MPACK_RING_HPP_
+#define MPACK_CPP__MPACK_RING_HPP_
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+/** Lock-free ring buffer of encoded messages in POSIX shared memory.
+ *
+ * Producers encode straight into space reserved in the ring and consumers decode
+ * straight from it, so a message is never copied between processes. Records have
+ * a variable size and are always contiguous: a record that does not fit before
+ * the end of the ring is preceded by padding and starts at the beginning.
+ *
+ * Every record starts with an 8 byte header, of which the first 4 bytes are an
+ * atomic size that is 0 until the record is committed. The consumer zeroes the
+ * records it releases, so a header is never mistaken for old data.
+ *
+ * Requires POSIX shared memory, the header is empty otherwise.
+ */
+
+#define MPACK_CPP_HAS_SHARED_RING 1
+
+namespace mpack_cpp {
+
+/** Number of producers that write to a `SharedRing`. There is always one consumer. */
+enum class RingProducers : std::uint32_t {
+    kSingle,    // One producer, space is reserved with a plain store.
+    kMultiple,  // Any number of producers, space is reserved with a compare-and-swap.
+};
+
+namespace internal {
+
+constexpr std::uint64_t kRingMagic{0x6d7061636b72696eULL};  // "mpackrin"
+constexpr std::size_t kRecordHeaderSize{8};
+constexpr std::size_t kMinRingCapacity{4096};
+constexpr std::size_t kMaxRingCapacity{std::size_t{1} << 30};
+
+using RecordSize = std::atomic<std::int32_t>;
+static_assert(RecordSize::is_always_lock_free && sizeof(RecordSize) == 4,
+              "SharedRing requires lock-free 32 bit atomics.");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "SharedRing requires lock-free 64 bit atomics.");
+
+/** Shared state at the start of the mapping, followed by the records. */
+struct RingHeader {
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t capacity;
+    RingProducers producers;
+    // Positions only grow, the offset in the ring is the position modulo capacity.
+    alignas(64) std::atomic<std::uint64_t> head;  // End of the reserved records.
+    alignas(64) std::atomic<std::uint64_t> tail;  // Start of the unreleased records.
+};
+
+/** Space taken by a record with `size` bytes of payload, including its header. */
+constexpr std::uint64_t RecordSpan(std::size_t size) {
+    return (kRecordHeaderSize + size + 7) & ~std::uint64_t{7};
+}
+
+}  // namespace internal
+
+/** Shared-memory ring buffer transport, see the top of this file.
+ *
+ * One process creates the ring, the others open it by name. The name follows the
+ * `shm_open` rules, it starts with a slash:
+ *
+ * ```
+ * // Producer
+ * mpack_cpp::SharedRing ring("/orders", 1 << 20, mpack_cpp::RingProducers::kMultiple);
+ * ring.Write(order);
+ *
+ * // Consumer
+ * mpack_cpp::SharedRing ring("/orders");
+ * while (ring.TryRead(order) == mpack_cpp::SharedRing::Status::kRead) { ... }
+ * ```
+ *
+ * Writing and reading never block, `Write` returns false when the ring is full and
+ * `TryRead` returns `kEmpty` when there is nothing to read, waiting is left to the
+ * caller. With `RingProducers::kMultiple` a `SharedRing` object may be shared by
+ * producer threads, the consumer side must only be used by a single thread.
+ */
+class SharedRing {
+   public:
+    /** Space reserved for one record, see `Reserve`. */
+    struct Slot {
+        char* data{nullptr};
+        std::size_t size{0};
+        std::uint64_t position{0};
+    };
+
+    enum class Status {
+        kEmpty,  // There is no committed record.
+        kRead,   // A record was decoded.
+        kError,  // A record was consumed, but could not be decoded.
+    };
+
+    SharedRing() = default;
+
+    /** Create a new ring of at least `capacity` bytes, rounded up to a power of 2. */
+    SharedRing(const std::string& name, std::size_t capacity,
+               RingProducers producers = RingProducers::kSingle) {
+        if (capacity > internal::kMaxRingCapacity) {
+            fprintf(stderr, "Could not create ring '%s', the capacity is too large!\n",
+                    name.c_str());
+            return;
+        }
+        std::size_t rounded{internal::kMinRingCapacity};
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            PrintError("shm_open", name);
+            return;
+        }
+        const std::size_t bytes = sizeof(internal::RingHeader) + rounded;
+        bool mapped{false};
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            PrintError("ftruncate", name);
+        } else {
+            mapped = Map(fd, bytes, name);
+        }
+        ::close(fd);
+        if (!mapped) {
+            ::shm_unlink(name.c_str());
+            return;
+        }
+
+        // The shared memory is zero filled, so all records are uncommitted.
+        header_ = new (mapping_) internal::RingHeader{};
+        header_->capacity = rounded;
+        header_->producers = producers;
+        header_->magic.store(internal::kRingMagic, std::memory_order_release);
+        Attach();
+    }
+
+    /** Open a ring created by another `SharedRing`. */
+    explicit SharedRing(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            PrintError("shm_open", name);
+            return;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            PrintError("fstat", name);
+            ::close(fd);
+            return;
+        }
+        const auto bytes = static_cast<std::size_t>(info.st_size);
+        bool mapped = bytes >= sizeof(internal::RingHeader) && Map(fd, bytes, name);
+        ::close(fd);
+        if (!mapped) {
+            fprintf(stderr, "'%s' is not a ring buffer!\n", name.c_str());
+            return;
+        }
+
+        header_ = static_cast<internal::RingHeader*>(mapping_);
+        if (header_->magic.load(std::memory_order_acquire) != internal::kRingMagic ||
+            header_->capacity + sizeof(internal::RingHeader) != mapping_size_) {
+            fprintf(stderr, "'%s' is not a ring buffer!\n", name.c_str());
+            Unmap();
+            return;
+        }
+        Attach();
+    }
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    SharedRing(SharedRing&& other) noexcept { *this = std::move(other); }
+
+    SharedRing& operator=(SharedRing&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+            mapping_ = std::exchange(other.mapping_, nullptr);
+            mapping_size_ = std::exchange(other.mapping_size_, 0);
+            header_ = std::exchange(other.header_, nullptr);
+            records_ = std::exchange(other.records_, nullptr);
+            capacity_ = std::exchange(other.capacity_, 0);
+            cached_tail_ = std::exchange(other.cached_tail_, 0);
+        }
+        return *this;
+    }
+
+    ~SharedRing() { Unmap(); }
+
+    /** Remove the name of a ring, it is freed once every process unmapped it. */
+    static bool Remove(const std::string& name) {
+        return ::shm_unlink(name.c_str()) == 0;
+    }
+
+    /** False when the ring could not be created or opened. */
+    bool is_open() const { return header_ != nullptr; }
+
+    std::size_t capacity() const { return capacity_; }
+
+    /** Largest payload of a single record, 0 when the ring is not open. */
+    std::size_t max_record_size() const {
+        return capacity_ == 0 ? 0 : capacity_ / 2 - internal::kRecordHeaderSize;
+    }
+
+    /** Reserve space for a record of `size` bytes, returns false when the ring is full.
+     *
+     * Every reserved slot must be finished with `Commit` or `Abort`, the consumer
+     * can not read past it before.
+     */
+    bool Reserve(std::size_t size, Slot& slot) {
+        if (header_ == nullptr) {
+            return false;
+        }
+        if (size > max_record_size()) {
+            fprintf(stderr, "A record of %zu bytes does not fit in the ring!\n", size);
+            return false;
+        }
+        const std::uint64_t span = internal::RecordSpan(size);
+        const bool single = header_->producers == RingProducers::kSingle;
+        std::uint64_t position = header_->head.load(std::memory_order_relaxed);
+        std::uint64_t padding{0};
+        while (true) {
+            // Records are contiguous, pad the end of the ring when it does not fit.
+            const std::uint64_t offset = position & (capacity_ - 1);
+            padding = capacity_ - offset < span ? capacity_ - offset : 0;
+            const std::uint64_t end = position + padding + span;
+            if (!HasSpace(end, single)) {
+                // `position` may be stale, the consumer can have released past it
+                // meanwhile. Only a head that did not move means the ring is full.
+                const std::uint64_t head = header_->head.load(std::memory_order_relaxed);
+                if (single || head == position) {
+                    return false;
+                }
+                position = head;
+                continue;
+            }
+            if (single) {
+                header_->head.store(end, std::memory_order_relaxed);
+                break;
+            }
+            if (header_->head.compare_exchange_weak(position, end,
+                                                    std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        if (padding > 0) {
+            SizeAt(position).store(-static_cast<std::int32_t>(padding),
+                                   std::memory_order_release);
+            position += padding;
+        }
+        slot = Slot{RecordAt(position) + internal::kRecordHeaderSize, size, position};
+        return true;
+    }
+
+    /** Publish a reserved slot with the first `length` bytes as payload. */
+    void Commit(const Slot& slot, std::size_t length) {
+        char* record = RecordAt(slot.position);
+        auto payload = static_cast<std::uint32_t>(length);
+        std::memcpy(record + sizeof(internal::RecordSize), &payload, sizeof(payload));
+        SizeAt(slot.position)
+            .store(static_cast<std::int32_t>(internal::RecordSpan(slot.size)),
+                   std::memory_order_release);
+    }
+
+    /** Give up a reserved slot, the consumer skips it. */
+    void Abort(const Slot& slot) {
+        SizeAt(slot.position)
+            .store(-static_cast<std::int32_t>(internal::RecordSpan(slot.size)),
+                   std::memory_order_release);
+    }
+
+    /** Encode `data` straight into the ring, returns false when it is full.
+     *
+     * Types with a bounded encoded size reserve `MaxEncodedSize`, others are sized
+     * exactly with `EncodedSize` first.
+     */
+    template <typename T>
+    bool Write(const T& data) {
+        if (header_ == nullptr) {
+            return false;
+        }
+        std::size_t size = internal::MaxSize<T>::value;
+        if (size > max_record_size()) {  // Unbounded, or a bound that is too large.
+            size = EncodedSize(data);
+            if (size == 0) {
+                return false;
+            }
+        }
+        Slot slot;
+        if (!Reserve(size, slot)) {
+            return false;
+        }
+        std::size_t n = WriteToMsgPack(data, slot.data, slot.size);
+        if (n == 0) {
+            Abort(slot);
+            return false;
+        }
+        Commit(slot, n);
+        return true;
+    }
+
+    /** View the payload of the next committed record, without consuming it.
+     *
+     * The view stays valid until `Release`, zero-copy fields decoded from it too.
+     */
+    bool Peek(BytesView& record) {
+        if (header_ == nullptr) {
+            return false;
+        }
+        std::uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        while (true) {
+            std::int32_t size = SizeAt(tail).load(std::memory_order_acquire);
+            if (size == 0) {
+                return false;
+            }
+            if (size < 0) {
+                tail = Consume(tail, static_cast<std::uint64_t>(-size));
+                continue;
+            }
+            std::uint32_t payload{0};
+            std::memcpy(&payload, RecordAt(tail) + sizeof(internal::RecordSize),
+                        sizeof(payload));
+            record = BytesView{RecordAt(tail) + internal::kRecordHeaderSize, payload};
+            return true;
+        }
+    }
+
+    /** Consume the record returned by `Peek`, its space can be reused. */
+    void Release() {
+        if (header_ == nullptr) {
+            return;
+        }
+        std::uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        std::int32_t size = SizeAt(tail).load(std::memory_order_relaxed);
+        if (size > 0) {
+            Consume(tail, static_cast<std::uint64_t>(size));
+        }
+    }
+
+    /** Decode and consume the next record.
+     *
+     * Zero-copy fields would point into released space, use `Peek` for those.
+     * A ring that is not open is always empty.
+     */
+    template <typename T>
+    Status TryRead(T& data) {
+        BytesView record;
+        if (!Peek(record)) {
+            return Status::kEmpty;
+        }
+        bool success = ReadFromMsgPack(data, record.data, record.size);
+        Release();
+        return success ? Status::kRead : Status::kError;
+    }
+
+   private:
+    static void PrintError(const char* call, const std::string& name) {
+        fprintf(stderr, "Could not map ring '%s', %s failed!\n", name.c_str(), call);
+        fprintf(stderr, "%s!\n", std::strerror(errno));
+    }
+
+    bool Map(int fd, std::size_t bytes, const std::string& name) {
+        void* mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            PrintError("mmap", name);
+            return false;
+        }
+        mapping_ = mapping;
+        mapping_size_ = bytes;
+        return true;
+    }
+
+    void Attach() {
+        records_ = static_cast<char*>(mapping_) + sizeof(internal::RingHeader);
+        capacity_ = header_->capacity;
+    }
+
+    void Unmap() {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+        }
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+        header_ = nullptr;
+        records_ = nullptr;
+        capacity_ = 0;
+    }
+
+    /** True when the records up to `end` fit behind the consumer. */
+    bool HasSpace(std::uint64_t end, bool single) {
+        // Only a single producer can cache the tail, it is the only writer of this
+        // object.
+        if (single && end - cached_tail_ <= capacity_) {
+            return true;
+        }
+        std::uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        if (single) {
+            cached_tail_ = tail;
+        }
+        return end - tail <= capacity_;
+    }
+
+    char* RecordAt(std::uint64_t position) {
+        return records_ + (position & (capacity_ - 1));
+    }
+
+    internal::RecordSize& SizeAt(std::uint64_t position) {
+        return *reinterpret_cast<internal::RecordSize*>(RecordAt(position));
+    }
+
+    /** Zero a record and move the tail past it, returns the new tail. */
+    std::uint64_t Consume(std::uint64_t tail, std::uint64_t span) {
+        // A later record header may start anywhere in this record.
+        std::memset(RecordAt(tail) + sizeof(internal::RecordSize), 0,
+                    span - sizeof(internal::RecordSize));
+        SizeAt(tail).store(0, std::memory_order_relaxed);
+        header_->tail.store(tail + span, std::memory_order_release);
+        return tail + span;
+    }
+
+    void* mapping_{nullptr};
+    std::size_t mapping_size_{0};
+    internal::RingHeader* header_{nullptr};
+    char* records_{nullptr};
+    std::uint64_t capacity_{0};
+    std::uint64_t cached_tail_{0};  // Last tail seen by a single producer.
+};
+
+}  // namespace mpack_cpp
+
+#endif  // __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+
+#endif  //  MPACK_CPP__MPACK_RING_HPP_
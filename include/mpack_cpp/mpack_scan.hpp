@@ -0,0 +1,254 @@
+#ifndef MPACK_CPP__MPACK_SCAN_HPP_
+#define MPACK_CPP__MPACK_SCAN_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/** Skip-scanning of encoded MessagePack objects.
+ *
+ * Finds where objects end by reading only their headers, without building a node
+ * tree or decoding any values.
+ */
+
+namespace mpack_cpp {
+namespace internal {
+
+/** Size in bytes of the first MessagePack object in `data`.
+ *
+ * Returns 0 when `data` does not start with a complete, valid object.
+ */
+inline std::size_t ScanObject(const char* data, std::size_t size) {
+    enum class Kind { kScalar, kBytes, kExt, kArray, kMap };
+
+    std::size_t pos{0};
+    std::uint64_t pending{1};  // Objects left to skip, children included.
+    while (pending > 0) {
+        if (pos >= size) {
+            return 0;
+        }
+        const auto tag = static_cast<std::uint8_t>(data[pos]);
+        Kind kind{Kind::kScalar};
+        std::uint64_t length{0};
+        std::size_t length_bytes{0};
+
+        if (tag <= 0x7f || tag >= 0xe0) {
+            // positive or negative fixint
+        } else if (tag <= 0x8f) {
+            kind = Kind::kMap;
+            length = tag & 0x0fu;
+        } else if (tag <= 0x9f) {
+            kind = Kind::kArray;
+            length = tag & 0x0fu;
+        } else if (tag <= 0xbf) {
+            kind = Kind::kBytes;
+            length = tag & 0x1fu;
+        } else {
+            switch (tag) {
+                case 0xc0:  // nil
+                case 0xc2:  // false
+                case 0xc3:  // true
+                    break;
+                case 0xc4:  // bin8
+                case 0xd9:  // str8
+                    kind = Kind::kBytes;
+                    length_bytes = 1;
+                    break;
+                case 0xc5:  // bin16
+                case 0xda:  // str16
+                    kind = Kind::kBytes;
+                    length_bytes = 2;
+                    break;
+                case 0xc6:  // bin32
+                case 0xdb:  // str32
+                    kind = Kind::kBytes;
+                    length_bytes = 4;
+                    break;
+                case 0xc7:  // ext8
+                    kind = Kind::kExt;
+                    length_bytes = 1;
+                    break;
+                case 0xc8:  // ext16
+                    kind = Kind::kExt;
+                    length_bytes = 2;
+                    break;
+                case 0xc9:  // ext32
+                    kind = Kind::kExt;
+                    length_bytes = 4;
+                    break;
+                case 0xcc:  // uint8
+                case 0xd0:  // int8
+                    kind = Kind::kBytes;
+                    length = 1;
+                    break;
+                case 0xcd:  // uint16
+                case 0xd1:  // int16
+                    kind = Kind::kBytes;
+                    length = 2;
+                    break;
+                case 0xca:  // float32
+                case 0xce:  // uint32
+                case 0xd2:  // int32
+                    kind = Kind::kBytes;
+                    length = 4;
+                    break;
+                case 0xcb:  // float64
+                case 0xcf:  // uint64
+                case 0xd3:  // int64
+                    kind = Kind::kBytes;
+                    length = 8;
+                    break;
+                case 0xd4:  // fixext1 to fixext16, type byte included
+                case 0xd5:
+                case 0xd6:
+                case 0xd7:
+                case 0xd8:
+                    kind = Kind::kBytes;
+                    length = (std::uint64_t{1} << (tag - 0xd4)) + 1;
+                    break;
+                case 0xdc:  // array16
+                    kind = Kind::kArray;
+                    length_bytes = 2;
+                    break;
+                case 0xdd:  // array32
+                    kind = Kind::kArray;
+                    length_bytes = 4;
+                    break;
+                case 0xde:  // map16
+                    kind = Kind::kMap;
+                    length_bytes = 2;
+                    break;
+                case 0xdf:  // map32
+                    kind = Kind::kMap;
+                    length_bytes = 4;
+                    break;
+                default:  // 0xc1 is never used
+                    return 0;
+            }
+        }
+
+        ++pos;
+        if (length_bytes > size - pos) {
+            return 0;
+        }
+        for (std::size_t i{0}; i < length_bytes; ++i) {
+            length = (length << 8) | static_cast<std::uint8_t>(data[pos++]);
+        }
+
+        --pending;
+        switch (kind) {
+            case Kind::kScalar:
+                break;
+            case Kind::kExt:
+                ++length;  // type byte
+                [[fallthrough]];
+            case Kind::kBytes:
+                if (length > size - pos) {
+                    return 0;
+                }
+                pos += static_cast<std::size_t>(length);
+                break;
+            case Kind::kArray:
+                pending += length;
+                break;
+            case Kind::kMap:
+                pending += 2 * length;
+                break;
+        }
+    }
+    return pos;
+}
+
+/** Size in bytes of the array or map header at the start of `data`.
+ *
+ * `fix_tag` is the first tag of the 16 fix variants, `tag16` the tag of the 16-bit
+ * variant, which is followed by the 32-bit variant.
+ */
+inline std::size_t ScanContainerHeader(const char* data, std::size_t size,
+                                       std::uint8_t fix_tag, std::uint8_t tag16,
+                                       std::uint32_t& count) {
+    if (size == 0) {
+        return 0;
+    }
+    const auto tag = static_cast<std::uint8_t>(data[0]);
+    std::size_t header{1};
+    if (tag >= fix_tag && tag <= fix_tag + 0x0f) {
+        count = tag & 0x0fu;
+        return header;
+    } else if (tag == tag16) {
+        header = 3;
+    } else if (tag == tag16 + 1) {
+        header = 5;
+    } else {
+        return 0;
+    }
+    if (size < header) {
+        return 0;
+    }
+    count = 0;
+    for (std::size_t i{1}; i < header; ++i) {
+        count = (count << 8) | static_cast<std::uint8_t>(data[i]);
+    }
+    return header;
+}
+
+/** Size in bytes of the array header at the start of `data`.
+ *
+ * Returns 0 when `data` does not start with a complete array header, otherwise
+ * `count` receives the number of elements.
+ */
+inline std::size_t ScanArrayHeader(const char* data, std::size_t size,
+                                   std::uint32_t& count) {
+    return ScanContainerHeader(data, size, 0x90, 0xdc, count);
+}
+
+/** Size in bytes of the map header at the start of `data`.
+ *
+ * Returns 0 when `data` does not start with a complete map header, otherwise
+ * `count` receives the number of key-value pairs.
+ */
+inline std::size_t ScanMapHeader(const char* data, std::size_t size,
+                                 std::uint32_t& count) {
+    return ScanContainerHeader(data, size, 0x80, 0xde, count);
+}
+
+/** Size in bytes of the string at the start of `data`, header included.
+ *
+ * Returns 0 when `data` does not start with a complete string, otherwise `str`
+ * receives a view on its characters.
+ */
+inline std::size_t ScanStr(const char* data, std::size_t size, std::string_view& str) {
+    if (size == 0) {
+        return 0;
+    }
+    const auto tag = static_cast<std::uint8_t>(data[0]);
+    std::size_t header{1};
+    std::size_t length{0};
+    if (tag >= 0xa0 && tag <= 0xbf) {
+        length = tag & 0x1fu;
+    } else if (tag == 0xd9) {
+        header = 2;
+    } else if (tag == 0xda) {
+        header = 3;
+    } else if (tag == 0xdb) {
+        header = 5;
+    } else {
+        return 0;
+    }
+    if (size < header) {
+        return 0;
+    }
+    for (std::size_t i{1}; i < header; ++i) {
+        length = (length << 8) | static_cast<std::uint8_t>(data[i]);
+    }
+    if (length > size - header) {
+        return 0;
+    }
+    str = std::string_view(data + header, length);
+    return header + length;
+}
+
+}  // namespace internal
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_SCAN_HPP_
@@ -0,0 +1,149 @@
+#ifndef MPACK_CPP__MPACK_STATS_HPP_
+#define MPACK_CPP__MPACK_STATS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <typeinfo>
+
+/** Optional per-call statistics of encoding and decoding.
+ *
+ * Compiled out unless `MPACK_CPP_INSTRUMENTATION` is defined (CMake option
+ * `MPACK_CPP_INSTRUMENTATION`), in which case every top-level encode or decode
+ * call records a `CallStats`. The statistics of the last call on a thread are
+ * available with `LastCallStats`, and a callback set with `SetStatsCallback`
+ * receives them after every call:
+ *
+ * ```
+ * mpack_cpp::SetStatsCallback([](const mpack_cpp::CallStats& stats) {
+ *     metrics.Record(stats.type_name, stats.bytes_in, stats.elapsed);
+ * });
+ * ```
+ *
+ * The macro must have the same value in every translation unit of a program.
+ */
+
+namespace mpack_cpp {
+
+#if defined(MPACK_CPP_INSTRUMENTATION)
+constexpr bool kStatsEnabled{true};
+#else
+constexpr bool kStatsEnabled{false};
+#endif
+
+/** Statistics of a single encode or decode call. */
+struct CallStats {
+    enum class Operation { kEncode, kDecode };
+
+    Operation operation{Operation::kDecode};
+    /** `typeid(T).name()` of the encoded or decoded type. */
+    const char* type_name{""};
+    /** Encoded bytes consumed by a decode. */
+    std::size_t bytes_in{0};
+    /** Encoded bytes produced by an encode. */
+    std::size_t bytes_out{0};
+    /** Parse nodes used by the node reader. */
+    std::size_t nodes{0};
+    /** Node pool reallocations of a `Decoder`. */
+    std::size_t pool_growths{0};
+    /** Strings and vectors that (re)allocated their storage while decoding. */
+    std::size_t container_allocations{0};
+    /** Maps buffered by the mpack map builder while encoding. */
+    std::size_t map_builds{0};
+    std::chrono::nanoseconds elapsed{0};
+};
+
+/** Receives the statistics of every call, on the thread that made the call. */
+using StatsCallback = void (*)(const CallStats& stats);
+
+namespace internal {
+
+struct StatsState {
+    CallStats current;
+    CallStats last;
+    int depth{0};
+};
+
+inline StatsState& ThreadStats() {
+    thread_local StatsState state;
+    return state;
+}
+
+inline std::atomic<StatsCallback>& GlobalStatsCallback() {
+    static std::atomic<StatsCallback> callback{nullptr};
+    return callback;
+}
+
+/** Add `n` to a field of the statistics of the call in progress. */
+inline void AddStat(std::size_t CallStats::*field, std::size_t n) {
+    if constexpr (kStatsEnabled) {
+        ThreadStats().current.*field += n;
+    }
+}
+
+/** Run `resize()` and count it when it changes the capacity of `container`. */
+template <typename ContainerT, typename ResizeT>
+void TrackGrowth(ContainerT& container, const ResizeT& resize) {
+    if constexpr (kStatsEnabled) {
+        const auto capacity = container.capacity();
+        resize();
+        if (container.capacity() != capacity) {
+            AddStat(&CallStats::container_allocations, 1);
+        }
+    } else {
+        resize();
+    }
+}
+
+/** Records the statistics of the outermost encode or decode call on this thread.
+ *
+ * Nested calls, like the per-item decodes of a batch, add to the outer call.
+ */
+template <typename T>
+class StatsScope {
+   public:
+    explicit StatsScope(CallStats::Operation operation) {
+        if constexpr (kStatsEnabled) {
+            auto& state = ThreadStats();
+            if (state.depth++ == 0) {
+                state.current = CallStats{};
+                state.current.operation = operation;
+                state.current.type_name = typeid(T).name();
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+    ~StatsScope() {
+        if constexpr (kStatsEnabled) {
+            auto& state = ThreadStats();
+            if (--state.depth == 0) {
+                state.current.elapsed = std::chrono::steady_clock::now() - start_;
+                state.last = state.current;
+                if (auto callback = GlobalStatsCallback().load()) {
+                    callback(state.last);
+                }
+            }
+        }
+    }
+
+   private:
+    std::chrono::steady_clock::time_point start_{};
+};
+
+}  // namespace internal
+
+/** Set the callback that receives the statistics of every call, null to disable. */
+inline void SetStatsCallback(StatsCallback callback) {
+    internal::GlobalStatsCallback().store(callback);
+}
+
+/** Statistics of the last completed call on this thread. */
+inline const CallStats& LastCallStats() { return internal::ThreadStats().last; }
+
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_STATS_HPP_
@@ -0,0 +1,91 @@
+#ifndef MPACK_CPP__MPACK_TYPES_HPP_
+#define MPACK_CPP__MPACK_TYPES_HPP_
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+namespace mpack_cpp {
+
+/** Non-owning view on binary data.
+ *
+ * Encoded as MessagePack 'bin'. When decoded with the node reader, the view
+ * points straight into the input buffer, so it is only valid as long as that
+ * buffer is alive.
+ */
+struct BytesView {
+    const char* data{nullptr};
+    std::size_t size{0};
+};
+
+/** Field wrapper to encode a contiguous array of numbers as a single 'bin' blob.
+ *
+ * Instead of a MessagePack array with a type tag per element, the elements are
+ * stored as one blob in little-endian byte order, which is as fast as a memcpy
+ * on most hardware. The element type is not stored, so the data must be decoded
+ * with the same wrapper and element type.
+ *
+ * ```
+ * mpack_cpp::WriteField(writer, "samples", mpack_cpp::Packed{samples});
+ * mpack_cpp::ReadField(node, "samples", mpack_cpp::Packed{samples});
+ * ```
+ */
+template <typename ContainerT>
+struct Packed {
+    ContainerT& values;
+};
+
+template <typename ContainerT>
+Packed(ContainerT&) -> Packed<ContainerT>;
+
+/** Layout of a batch of messages, see `WriteBatch` and `ReadBatch`. */
+enum class BatchFormat {
+    kConcatenated,  // Separate messages written back to back.
+    kArray,         // A single message holding an array of the items.
+};
+
+/** Size of the buffer used to stream data from or to a source or sink. */
+constexpr std::size_t kStreamBufferSize{16 * 1024};
+
+/** POSIX file descriptor to stream MessagePack data from or to.
+ *
+ * The descriptor is borrowed, it is not closed after reading or writing.
+ */
+struct FileDescriptor {
+    int fd{-1};
+};
+
+namespace internal {
+
+template <typename T>
+struct IsOptional : std::false_type {};
+
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+/** Key and member pointer of a struct member, listed by `MPACK_CPP_DEFINE`. */
+template <typename T, typename C>
+struct FieldKey {
+    std::string_view key;
+    T C::*member;
+};
+
+template <typename T, typename C>
+constexpr FieldKey<T, C> MakeFieldKey(std::string_view key, T C::*member) {
+    return {key, member};
+}
+
+}  // namespace internal
+
+}  // namespace mpack_cpp
+
+#endif  //  MPACK_CPP__MPACK_TYPES_HPP_
@@ -1,23 +1,147 @@
 #ifndef MPACK_CPP__MPACK_WRITER_HPP_
 #define MPACK_CPP__MPACK_WRITER_HPP_
 
+#include <algorithm>
 #include <array>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "mpack.h"  //  NOLINT
+#include "mpack_cpp/mpack_bulk.hpp"
+#include "mpack_cpp/mpack_stats.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
 
 namespace mpack_cpp {
 namespace internal {
 
-/** Main type selection visitor to encode values.
+/** Number of map entries written for a field, optionals without value are omitted. */
+template <typename T>
+constexpr std::uint32_t FieldCount(const T& field) {
+    if constexpr (IsOptional<T>::value) {
+        return field.has_value() ? 1 : 0;
+    } else {
+        return 1;
+    }
+}
+
+/** Detect custom types that report their map size before they are encoded. */
+template <typename T, typename = void>
+struct HasMapSize : std::false_type {};
+
+template <typename T>
+struct HasMapSize<
+    T, std::void_t<decltype(std::declval<const T&>().message_pack_map_size())>>
+    : std::true_type {};
+
+/** Marks types without an upper bound on their encoded size, see `MaxSize`. */
+constexpr std::size_t kUnboundedSize{SIZE_MAX};
+
+constexpr std::size_t AddSizes(std::size_t lhs, std::size_t rhs) {
+    return (lhs == kUnboundedSize || rhs == kUnboundedSize) ? kUnboundedSize : lhs + rhs;
+}
+
+/** Largest array or map header for `count` elements. */
+constexpr std::size_t ContainerHeaderMaxSize(std::size_t count) {
+    return count <= 15 ? 1 : (count <= 0xffff ? 3 : 5);
+}
+
+/** Upper bound of the encoded size of every value of `T`.
  *
- * In contrast other MessagePack encoders, integers are written to fixed int types based
- * on the C++ type, not based on there value. This can result in larger message size.
+ * Integers are bounded by the widest encoding of their type. Types with a variable
+ * size, like strings and vectors, are `kUnboundedSize`.
+ */
+template <typename T, typename = void>
+struct MaxSize : std::integral_constant<std::size_t, kUnboundedSize> {};
+
+template <std::size_t N>
+using SizeConstant = std::integral_constant<std::size_t, N>;
+
+template <>
+struct MaxSize<bool> : SizeConstant<1> {};
+template <>
+struct MaxSize<float> : SizeConstant<5> {};
+template <>
+struct MaxSize<double> : SizeConstant<9> {};
+template <>
+struct MaxSize<std::uint8_t> : SizeConstant<2> {};
+template <>
+struct MaxSize<std::uint16_t> : SizeConstant<3> {};
+template <>
+struct MaxSize<std::uint32_t> : SizeConstant<5> {};
+template <>
+struct MaxSize<std::uint64_t> : SizeConstant<9> {};
+template <>
+struct MaxSize<std::int8_t> : SizeConstant<2> {};
+template <>
+struct MaxSize<std::int16_t> : SizeConstant<3> {};
+template <>
+struct MaxSize<std::int32_t> : SizeConstant<5> {};
+template <>
+struct MaxSize<std::int64_t> : SizeConstant<9> {};
+
+template <typename T>
+struct MaxSize<std::optional<T>> : MaxSize<T> {};
+
+template <typename T, std::size_t N>
+struct MaxSize<std::array<T, N>>
+    : SizeConstant<(MaxSize<T>::value == kUnboundedSize ||
+                    (N > 0 && MaxSize<T>::value > (kUnboundedSize - 5) / N))
+                       ? kUnboundedSize
+                       : ContainerHeaderMaxSize(N) + N * MaxSize<T>::value> {};
+
+template <typename First, typename Second>
+struct MaxSize<std::pair<First, Second>>
+    : SizeConstant<AddSizes(1, AddSizes(MaxSize<First>::value,
+                                        MaxSize<Second>::value))> {};
+
+template <typename... Args>
+struct MaxSize<std::variant<Args...>>
+    : SizeConstant<std::max({MaxSize<Args>::value...})> {};
+
+/** Custom types defined with `MPACK_CPP_DEFINE` report their own bound. */
+template <typename T>
+struct MaxSize<T, std::void_t<decltype(T::message_pack_max_size())>>
+    : SizeConstant<T::message_pack_max_size()> {};
+
+/** Upper bound of a map entry with a key of `key_length` characters. */
+template <typename T>
+constexpr std::size_t MaxFieldSize(std::size_t key_length) {
+    std::size_t key_header = key_length <= 31 ? 1 : (key_length <= 0xff ? 2 : 3);
+    return AddSizes(key_header + key_length, MaxSize<T>::value);
+}
+
+/** Upper bound of a map with the given upper bounds of its entries. */
+template <typename... Sizes>
+constexpr std::size_t MaxMapSize(Sizes... fields) {
+    std::size_t size = ContainerHeaderMaxSize(sizeof...(Sizes));
+    ((size = AddSizes(size, fields)), ...);
+    return size;
+}
+
+/** Main type selection visitor to encode values.
  *
+ * Integers are written with the smallest MessagePack encoding that holds the value,
+ * independent of the C++ type, e.g. a `std::uint64_t` of 5 takes a single byte. Both
+ * readers accept every encoding that fits into the target type.
  */
 struct WriteVisitor {
     mpack_writer_t& writer;
@@ -48,14 +172,59 @@ struct WriteVisitor {
                          static_cast<std::uint32_t>(value.size()));
     }
 
+    void operator()(std::string_view value) {
+        mpack_write_utf8(&writer, value.data(), static_cast<std::uint32_t>(value.size()));
+    }
+
+    void operator()(const BytesView& value) {
+        mpack_write_bin(&writer, value.data, static_cast<std::uint32_t>(value.size));
+    }
+
+#if defined(__cpp_lib_span)
+    void operator()(std::span<const char> value) {
+        mpack_write_bin(&writer, value.data(), static_cast<std::uint32_t>(value.size()));
+    }
+#endif
+
     template <typename ElemT, typename AllocT>
     void operator()(const std::vector<ElemT, AllocT>& vec) {
-        mpack_start_array(&writer, static_cast<std::uint32_t>(vec.size()));
-        for (const auto& elem : vec) {
-            // Recursively process each element in the vector.
-            (*this)(elem);
+        WriteArray(vec.data(), vec.size());
+    }
+
+    template <typename ElemT, std::size_t N>
+    void operator()(const std::array<ElemT, N>& arr) {
+        WriteArray(arr.data(), arr.size());
+    }
+
+#if defined(__cpp_lib_span)
+    template <typename ElemT, std::size_t Extent>
+    void operator()(std::span<ElemT, Extent> span) {
+        WriteArray(span.data(), span.size());
+    }
+#endif
+
+    /** Write contiguous numbers as a single little-endian 'bin', see `Packed`. */
+    template <typename ContainerT>
+    void operator()(const Packed<ContainerT>& packed) {
+        using ElemT = std::remove_cv_t<typename ContainerT::value_type>;
+        static_assert(internal::IsBulkNumber<ElemT>::value,
+                      "Packed requires a container of numbers.");
+        constexpr std::size_t kChunkCount{64};
+
+        const std::size_t count = packed.values.size();
+        const auto* data = reinterpret_cast<const char*>(packed.values.data());
+        mpack_start_bin(&writer, static_cast<std::uint32_t>(count * sizeof(ElemT)));
+        if constexpr (internal::kLittleEndian) {
+            mpack_write_bytes(&writer, data, count * sizeof(ElemT));
+        } else {
+            char chunk[kChunkCount * sizeof(ElemT)];
+            for (std::size_t i{0}; i < count; i += kChunkCount) {
+                std::size_t n = std::min(kChunkCount, count - i);
+                internal::CopyLittleEndian<ElemT>(chunk, data + i * sizeof(ElemT), n);
+                mpack_write_bytes(&writer, chunk, n * sizeof(ElemT));
+            }
         }
-        mpack_finish_array(&writer);
+        mpack_finish_bin(&writer);
     }
 
     template <typename First, typename Second>
@@ -71,14 +240,46 @@ struct WriteVisitor {
         std::visit(*this, variant);
     }
 
-    /** @brief   Recursively process custom types. */
+    /** Write a MessagePack array, numbers are encoded in bulk.
+     *
+     * The bulk path writes the same bytes as writing every element separately.
+     */
+    template <typename ElemT>
+    void WriteArray(const ElemT* data, std::size_t count) {
+        mpack_start_array(&writer, static_cast<std::uint32_t>(count));
+        if constexpr (internal::IsBulkNumber<std::remove_cv_t<ElemT>>::value &&
+                      !internal::kWriteTracking) {
+            internal::WriteNumbers(writer, data, count);
+        } else {
+            for (std::size_t i{0}; i < count; ++i) {
+                // Recursively process each element in the array.
+                (*this)(data[i]);
+            }
+        }
+        mpack_finish_array(&writer);
+    }
+
+    /** @brief   Recursively process custom types.
+     *
+     * Types that provide `message_pack_map_size()`, like the ones defined with
+     * `MPACK_CPP_DEFINE`, get their map header written up front. Other types are
+     * collected by an mpack map builder, which counts the entries afterwards at the
+     * cost of buffering the map.
+     */
     template <typename T>
     void operator()(const T& value) {
         // The method 'to_message_pack' calls 'AddField' which will
         // call into this visitor again recursively.
-        mpack_build_map(&writer);
-        value.to_message_pack(writer);
-        mpack_complete_map(&writer);
+        if constexpr (HasMapSize<T>::value) {
+            mpack_start_map(&writer, value.message_pack_map_size());
+            value.to_message_pack(writer);
+            mpack_finish_map(&writer);
+        } else {
+            AddStat(&CallStats::map_builds, 1);
+            mpack_build_map(&writer);
+            value.to_message_pack(writer);
+            mpack_complete_map(&writer);
+        }
     }
 };
 
@@ -90,17 +291,83 @@ struct WriteVisitor {
  * */
 using WriteCtx = mpack_writer_t;
 
-/** Add a basic generic field to the given mpack writer. */
-template <typename T>
-void WriteField(WriteCtx& writer, const char* key, T&& value) {
+/** Map key encoded at compile time, including the MessagePack str header.
+ *
+ * Writing it is a single copy instead of a `strlen` and header encoding for
+ * every message. Create it with `EncodeKey`.
+ */
+template <std::size_t N>
+struct EncodedKey {
+    std::array<char, N + 2> data{};  // N - 1 characters and up to 3 header bytes.
+    std::size_t size{0};
+};
+
+/** Encode a string literal as map key, in the same way as `mpack_write_cstr`.
+ *
+ * ```
+ * static constexpr auto kName = mpack_cpp::EncodeKey("name");
+ * mpack_cpp::WriteField(writer, kName, name);
+ * ```
+ */
+template <std::size_t N>
+constexpr EncodedKey<N> EncodeKey(const char (&key)[N]) {
+    constexpr std::size_t length = N - 1;
+    static_assert(length <= 0xffff, "Keys longer than 65535 bytes are not supported.");
+
+    EncodedKey<N> out{};
+    if constexpr (length <= 31) {
+        out.data[out.size++] = static_cast<char>(0xa0 | length);  // fixstr
+    } else if constexpr (length <= 0xff) {
+        out.data[out.size++] = static_cast<char>(0xd9);  // str8
+        out.data[out.size++] = static_cast<char>(length);
+    } else {
+        out.data[out.size++] = static_cast<char>(0xda);  // str16
+        out.data[out.size++] = static_cast<char>(length >> 8);
+        out.data[out.size++] = static_cast<char>(length & 0xff);
+    }
+    for (std::size_t i{0}; i < length; ++i) {
+        out.data[out.size++] = key[i];
+    }
+    return out;
+}
+
+namespace internal {
+
+inline void WriteKey(mpack_writer_t& writer, const char* key) {
     mpack_write_cstr(&writer, key);
-    internal::WriteVisitor{writer}(std::forward<T>(value));
 }
 
-template <typename T>
-void WriteOptionalField(WriteCtx& writer, const char* key, T&& value) {
+template <std::size_t N>
+void WriteKey(mpack_writer_t& writer, const EncodedKey<N>& key) {
+    mpack_write_object_bytes(&writer, key.data.data(), key.size);
+}
+
+}  // namespace internal
+
+/** Add an optional field, the key is omitted when there is no value.
+ *
+ * The key is either a `const char*` or an `EncodedKey`.
+ */
+template <typename KeyT, typename T>
+void WriteOptionalField(WriteCtx& writer, const KeyT& key, T&& value) {
     if (value.has_value()) {
-        WriteField(writer, key, value.value());
+        internal::WriteKey(writer, key);
+        internal::WriteVisitor{writer}(value.value());
+    }
+}
+
+/** Add a basic generic field to the given mpack writer.
+ *
+ * The key is either a `const char*` or an `EncodedKey`.
+ * `std::optional` values are forwarded to `WriteOptionalField`.
+ */
+template <typename KeyT, typename T>
+void WriteField(WriteCtx& writer, const KeyT& key, T&& value) {
+    if constexpr (internal::IsOptional<std::decay_t<T>>::value) {
+        WriteOptionalField(writer, key, std::forward<T>(value));
+    } else {
+        internal::WriteKey(writer, key);
+        internal::WriteVisitor{writer}(std::forward<T>(value));
     }
 }
 
@@ -116,6 +383,7 @@ void WriteExtField(WriteCtx& writer, const char* key, std::int8_t type,
 
 template <typename T>
 std::size_t WriteToMsgPack(const T& data, char* buffer_start, std::size_t buffer_size) {
+    internal::StatsScope<T> stats(CallStats::Operation::kEncode);
     mpack_writer_t writer;
     mpack_writer_init(&writer, buffer_start, buffer_size);
     internal::WriteVisitor{writer}(data);
@@ -127,6 +395,7 @@ std::size_t WriteToMsgPack(const T& data, char* buffer_start, std::size_t buffer
         fprintf(stderr, "%s!\n", mpack_error_to_string(err));
         return 0;
     } else {
+        internal::AddStat(&CallStats::bytes_out, n);
         return n;
     }
 }
@@ -142,6 +411,344 @@ std::size_t WriteToMsgPack(const T& msg, std::vector<ByteT>& buffer) {
     return WriteToMsgPack(msg, buffer.data(), buffer.size());
 }
 
+/** Growable destination for `WriteToMsgPack`.
+ *
+ * Wraps any contiguous byte container with `data()`, `size()` and `resize()`
+ * (`std::vector<char>`, `std::pmr::vector<std::uint8_t>`, `std::string`, ...).
+ * The encoded message is appended to the existing content of the container,
+ * which is grown geometrically while encoding and trimmed to the exact message
+ * size afterwards.
+ *
+ * ```
+ * std::vector<char> buffer;
+ * auto n = mpack_cpp::WriteToMsgPack(msg, mpack_cpp::GrowableBuffer{buffer});
+ * ```
+ */
+template <typename ContainerT>
+struct GrowableBuffer {
+    static_assert(sizeof(typename ContainerT::value_type) == 1,
+                  "GrowableBuffer requires a container of bytes.");
+    ContainerT& container;
+};
+
+template <typename ContainerT>
+GrowableBuffer(ContainerT&) -> GrowableBuffer<ContainerT>;
+
+namespace internal {
+
+/** Size of the first chunk reserved for the message in a `GrowableBuffer`. */
+constexpr std::size_t kGrowableInitialSize{256};
+
+template <typename ContainerT>
+struct GrowableState {
+    ContainerT& container;
+    std::size_t offset;  // Start of the message in the container.
+};
+
+/** Intrusive mpack flush function that grows the container instead of emptying it.
+ *
+ * This follows `mpack_growable_writer_flush` from mpack itself: the writer encodes
+ * directly into the container's memory, so there is no extra copy. The flush is
+ * called in three situations:
+ *   - the buffer is full (`data` is the buffer, nothing is marked used),
+ *   - a write does not fit even in an empty buffer (`data` is external),
+ *   - teardown (`data` is the buffer and everything is marked used).
+ * In the first two cases the buffer is at least doubled, the last one is a no-op.
+ */
+template <typename ContainerT>
+void GrowableFlush(mpack_writer_t* writer, const char* data, std::size_t count) {
+    auto& state = *static_cast<GrowableState<ContainerT>*>(mpack_writer_context(writer));
+
+    if (data == writer->buffer) {
+        if (mpack_writer_buffer_used(writer) == count) {
+            return;
+        }
+        // The data is already in place, just mark it as used again and grow.
+        writer->position = writer->buffer + count;
+        count = 0;
+    }
+
+    std::size_t used = mpack_writer_buffer_used(writer);
+    std::size_t new_size = mpack_writer_buffer_size(writer) * 2;
+    while (new_size < used + count) {
+        new_size *= 2;
+    }
+
+    try {
+        state.container.resize(state.offset + new_size);
+    } catch (...) {
+        mpack_writer_flag_error(writer, mpack_error_memory);
+        return;
+    }
+
+    char* buffer = reinterpret_cast<char*>(state.container.data()) + state.offset;
+    writer->buffer = buffer;
+    writer->position = buffer + used;
+    writer->end = buffer + new_size;
+
+    if (count > 0) {
+        std::memcpy(writer->position, data, count);
+        writer->position += count;
+    }
+}
+
+/** Run `encode(writer)` on a writer that appends to the container of `sink`. */
+template <typename ContainerT, typename EncodeT>
+std::size_t EncodeToGrowable(GrowableBuffer<ContainerT> sink, EncodeT&& encode) {
+    GrowableState<ContainerT> state{sink.container, sink.container.size()};
+    sink.container.resize(state.offset + kGrowableInitialSize);
+
+    mpack_writer_t writer;
+    mpack_writer_init(&writer,
+                      reinterpret_cast<char*>(sink.container.data()) + state.offset,
+                      kGrowableInitialSize);
+    mpack_writer_set_context(&writer, &state);
+    mpack_writer_set_flush(&writer, GrowableFlush<ContainerT>);
+    encode(writer);
+    std::size_t n = mpack_writer_buffer_used(&writer);
+
+    auto err = mpack_writer_destroy(&writer);
+    if (err != mpack_ok) {
+        sink.container.resize(state.offset);
+        fprintf(stderr, "An error occurred encoding the data!\n");
+        fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+        return 0;
+    } else {
+        sink.container.resize(state.offset + n);
+        AddStat(&CallStats::bytes_out, n);
+        return n;
+    }
+}
+
+}  // namespace internal
+
+/** Encode into a growable container, see `GrowableBuffer`.
+ *
+ * @return The number of bytes appended to the container, or 0 on error, in
+ * which case the container is restored to its original size.
+ */
+template <typename T, typename ContainerT>
+std::size_t WriteToMsgPack(const T& data, GrowableBuffer<ContainerT> sink) {
+    internal::StatsScope<T> stats(CallStats::Operation::kEncode);
+    return internal::EncodeToGrowable(
+        sink, [&data](mpack_writer_t& writer) { internal::WriteVisitor{writer}(data); });
+}
+
+/** Encode a range of messages with a single writer.
+ *
+ * The items are appended to the container as separate messages or as one array,
+ * see `BatchFormat`. When `offsets` is given, it receives the position of every
+ * item relative to the start of the batch, so items can be decoded one by one.
+ *
+ * @return The number of bytes appended to the container, or 0 on error, in
+ * which case the container is restored to its original size.
+ */
+template <typename RangeT, typename ContainerT>
+std::size_t WriteBatch(const RangeT& items, GrowableBuffer<ContainerT> sink,
+                       BatchFormat format = BatchFormat::kConcatenated,
+                       std::vector<std::size_t>* offsets = nullptr) {
+    internal::StatsScope<RangeT> stats(CallStats::Operation::kEncode);
+    if (offsets != nullptr) {
+        offsets->clear();
+    }
+    auto n = internal::EncodeToGrowable(sink, [&](mpack_writer_t& writer) {
+        if (format == BatchFormat::kArray) {
+            mpack_start_array(&writer, static_cast<std::uint32_t>(std::size(items)));
+        }
+        for (const auto& item : items) {
+            if (offsets != nullptr) {
+                offsets->push_back(mpack_writer_buffer_used(&writer));
+            }
+            internal::WriteVisitor{writer}(item);
+        }
+        if (format == BatchFormat::kArray) {
+            mpack_finish_array(&writer);
+        }
+    });
+    if (n == 0 && offsets != nullptr) {
+        offsets->clear();
+    }
+    return n;
+}
+
+/** Destination of streamed output, see `WriteToMsgPack`.
+ *
+ * Consumes `count` bytes from `data`, returns false on error.
+ */
+using FlushFunction = std::function<bool(const char* data, std::size_t count)>;
+
+namespace internal {
+
+struct StreamState {
+    const FlushFunction& flush;
+    std::size_t written;
+};
+
+inline void FlushToStream(mpack_writer_t* writer, const char* data, std::size_t count) {
+    auto& state = *static_cast<StreamState*>(mpack_writer_context(writer));
+    if (!state.flush(data, count)) {
+        mpack_writer_flag_error(writer, mpack_error_io);
+        return;
+    }
+    state.written += count;
+}
+
+}  // namespace internal
+
+/** Encode to streamed output.
+ *
+ * The message is encoded in a buffer of `buffer_size` bytes, which is flushed
+ * every time it is full, so memory use does not depend on the message size.
+ *
+ * @return The number of bytes flushed, or 0 on error.
+ */
+template <typename T>
+std::size_t WriteToMsgPack(const T& data, const FlushFunction& flush,
+                           std::size_t buffer_size = kStreamBufferSize) {
+    internal::StatsScope<T> stats(CallStats::Operation::kEncode);
+    internal::StreamState state{flush, 0};
+    std::vector<char> buffer(
+        std::max<std::size_t>(buffer_size, MPACK_WRITER_MINIMUM_BUFFER_SIZE));
+
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer.data(), buffer.size());
+    mpack_writer_set_context(&writer, &state);
+    mpack_writer_set_flush(&writer, internal::FlushToStream);
+    internal::WriteVisitor{writer}(data);
+
+    auto err = mpack_writer_destroy(&writer);
+    if (err != mpack_ok) {
+        fprintf(stderr, "An error occurred encoding the data!\n");
+        fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+        return 0;
+    } else {
+        internal::AddStat(&CallStats::bytes_out, state.written);
+        return state.written;
+    }
+}
+
+template <typename T>
+std::size_t WriteToMsgPack(const T& data, std::ostream& stream,
+                           std::size_t buffer_size = kStreamBufferSize) {
+    FlushFunction flush = [&stream](const char* out, std::size_t count) {
+        return stream.write(out, static_cast<std::streamsize>(count)).good();
+    };
+    return WriteToMsgPack(data, flush, buffer_size);
+}
+
+#if __has_include(<sys/uio.h>)
+namespace internal {
+/** Write all buffers with as few `writev` calls as possible. */
+inline bool WriteAll(int fd, std::vector<iovec>& buffers) {
+    std::size_t first{0};
+    while (first < buffers.size()) {
+        auto n_buffers = std::min<std::size_t>(buffers.size() - first, IOV_MAX);
+        ssize_t n = ::writev(fd, buffers.data() + first, static_cast<int>(n_buffers));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        auto written = static_cast<std::size_t>(n);
+        while (first < buffers.size() && written >= buffers[first].iov_len) {
+            written -= buffers[first].iov_len;
+            ++first;
+        }
+        if (written > 0) {
+            auto* base = static_cast<char*>(buffers[first].iov_base);
+            buffers[first].iov_base = base + written;
+            buffers[first].iov_len -= written;
+        }
+    }
+    return true;
+}
+}  // namespace internal
+#endif
+
+#if __has_include(<unistd.h>)
+template <typename T>
+std::size_t WriteToMsgPack(const T& data, FileDescriptor file,
+                           std::size_t buffer_size = kStreamBufferSize) {
+    FlushFunction flush = [file](const char* out, std::size_t count) {
+        while (count > 0) {
+            ssize_t n = ::write(file.fd, out, count);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            out += n;
+            count -= static_cast<std::size_t>(n);
+        }
+        return true;
+    };
+    return WriteToMsgPack(data, flush, buffer_size);
+}
+#endif
+
+namespace internal {
+
+inline void CountFlush(mpack_writer_t* writer, const char*, std::size_t count) {
+    *static_cast<std::size_t*>(mpack_writer_context(writer)) += count;
+}
+
+}  // namespace internal
+
+/** Exact number of bytes `WriteToMsgPack` produces for `data`.
+ *
+ * The value goes through the same visitor as when it is encoded, but into a small
+ * scratch buffer that is flushed by counting. For `MPACK_CPP_DEFINE` types nothing
+ * is allocated. Custom `to_message_pack` methods write maps without a size, which
+ * go through the mpack map builder, and that takes pages from `MPACK_MALLOC` once
+ * the scratch buffer is full. This allows a single exact allocation before
+ * encoding:
+ *
+ * ```
+ * std::vector<char> buffer(mpack_cpp::EncodedSize(msg));
+ * mpack_cpp::WriteToMsgPack(msg, buffer);
+ * ```
+ *
+ * @return The encoded size, or 0 on error.
+ */
+template <typename T>
+std::size_t EncodedSize(const T& data) {
+    std::array<char, 256> scratch;
+    std::size_t size{0};
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, scratch.data(), scratch.size());
+    mpack_writer_set_context(&writer, &size);
+    mpack_writer_set_flush(&writer, internal::CountFlush);
+    internal::WriteVisitor{writer}(data);
+
+    // Destroying the writer flushes the rest of the scratch buffer.
+    auto err = mpack_writer_destroy(&writer);
+    if (err != mpack_ok) {
+        fprintf(stderr, "An error occurred sizing the data!\n");
+        fprintf(stderr, "%s!\n", mpack_error_to_string(err));
+        return 0;
+    }
+    return size;
+}
+
+/** Upper bound of the encoded size of every value of `T`, at compile time.
+ *
+ * Only available for fixed-layout types: numbers, `bool`, `std::array`,
+ * `std::pair`, `std::variant`, `std::optional` and structs defined with
+ * `MPACK_CPP_DEFINE` that only contain those. Use it to size fixed buffers or slots:
+ *
+ * ```
+ * std::array<char, mpack_cpp::MaxEncodedSize<Position>()> slot;
+ * ```
+ */
+template <typename T>
+constexpr std::size_t MaxEncodedSize() {
+    static_assert(internal::MaxSize<T>::value != internal::kUnboundedSize,
+                  "The encoded size of this type is not bounded, use EncodedSize.");
+    return internal::MaxSize<T>::value;
+}
+
 }  // namespace mpack_cpp
 
 #endif  //  MPACK_CPP__MPACK_WRITER_HPP_
@@ -0,0 +1,107 @@
+#include "mpack_cpp/mpack_async.hpp"
+
+// Only defined with C++20 coroutines on POSIX systems.
+#if defined(MPACK_CPP_HAS_COROUTINES)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <coroutine>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+
+namespace {
+struct Packet {
+    std::uint32_t id;
+    std::string body;
+    MPACK_CPP_DEFINE(Packet, id, body)
+};
+
+/** Minimal executor: a suspended coroutine is parked until the test resumes it. */
+struct Park {
+    std::coroutine_handle<>& parked;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { parked = handle; }
+    void await_resume() const noexcept {}
+};
+
+mpack_cpp::Task<bool> ReadTwo(mpack_cpp::StreamDecoder& decoder, Packet& first,
+                              Packet& second, std::coroutine_handle<>& parked) {
+    auto wait = [&parked] { return Park{parked}; };
+    bool ok = co_await mpack_cpp::AsyncReadFromMsgPack(first, decoder, wait);
+    ok = ok && co_await mpack_cpp::AsyncReadFromMsgPack(second, decoder, wait);
+    co_return ok;
+}
+}  // namespace
+
+TEST(async, read_suspends_until_complete) {
+    std::vector<Packet> packets{{1, "first"}, {2, std::string(1000, 'b')}};
+    std::vector<char> buffer;
+    mpack_cpp::WriteBatch(packets, mpack_cpp::GrowableBuffer{buffer});
+
+    mpack_cpp::StreamDecoder decoder;
+    Packet first{};
+    Packet second{};
+    std::coroutine_handle<> parked;
+    auto task = ReadTwo(decoder, first, second, parked);
+    task.Resume();
+
+    std::size_t fed{0};
+    int suspensions{0};
+    while (!task.done()) {
+        ASSERT_LT(fed, buffer.size());
+        std::size_t n = std::min<std::size_t>(100, buffer.size() - fed);
+        decoder.Feed(buffer.data() + fed, n);
+        fed += n;
+        ++suspensions;
+        parked.resume();
+    }
+    EXPECT_TRUE(task.result());
+    EXPECT_GT(suspensions, 5);
+    EXPECT_EQ(first.id, 1);
+    EXPECT_EQ(second.body, packets[1].body);
+}
+
+TEST(async, write_suspends_while_pipe_is_full) {
+    Packet packet{7, std::string(300000, 'w')};  // Larger than a pipe buffer.
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+    ASSERT_EQ(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+
+    std::vector<char> scratch;
+    std::coroutine_handle<> parked;
+    auto task = mpack_cpp::AsyncWriteToMsgPack(packet, mpack_cpp::FileDescriptor{fds[1]},
+                                               scratch, [&] { return Park{parked}; });
+    task.Resume();
+
+    std::vector<char> received;
+    std::vector<char> chunk(65536);
+    int suspensions{0};
+    while (true) {
+        ssize_t n;
+        while ((n = read(fds[0], chunk.data(), chunk.size())) > 0) {
+            received.insert(received.end(), chunk.begin(), chunk.begin() + n);
+        }
+        if (task.done()) {
+            break;
+        }
+        ++suspensions;
+        parked.resume();
+    }
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_TRUE(task.result());
+    EXPECT_GT(suspensions, 0);
+    Packet after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, received.data(), received.size()));
+    EXPECT_EQ(after.id, packet.id);
+    EXPECT_EQ(after.body, packet.body);
+}
+
+#endif  // defined(MPACK_CPP_HAS_COROUTINES)
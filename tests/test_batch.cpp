@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Record {
+    std::uint32_t id;
+    std::string name;
+    std::vector<std::int16_t> values;
+    MPACK_CPP_DEFINE(Record, id, name, values)
+
+    bool operator==(const Record& other) const {
+        return id == other.id && name == other.name && values == other.values;
+    }
+};
+
+std::vector<Record> MakeRecords(std::uint32_t count) {
+    std::vector<Record> records;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        records.push_back({i, "record " + std::to_string(i), {}});
+        for (std::uint32_t j = 0; j < i % 5; ++j) {
+            records.back().values.push_back(static_cast<std::int16_t>(j * 1000));
+        }
+    }
+    return records;
+}
+}  // namespace
+
+TEST(batch, concatenated_round_trip) {
+    const auto records = MakeRecords(100);
+    std::vector<char> buffer;
+    std::vector<std::size_t> write_offsets;
+    auto n = mpack_cpp::WriteBatch(records, mpack_cpp::GrowableBuffer{buffer},
+                                   mpack_cpp::BatchFormat::kConcatenated, &write_offsets);
+    ASSERT_EQ(n, buffer.size());
+    ASSERT_EQ(write_offsets.size(), records.size());
+    EXPECT_EQ(write_offsets.front(), 0);
+
+    // Every item is a complete message on its own.
+    for (std::size_t i : {std::size_t{0}, std::size_t{42}, std::size_t{99}}) {
+        std::size_t end = i + 1 < write_offsets.size() ? write_offsets[i + 1] : n;
+        Record record{};
+        ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(record, buffer.data() + write_offsets[i],
+                                               end - write_offsets[i]));
+        EXPECT_EQ(record, records[i]);
+    }
+
+    std::vector<Record> after(3);  // Existing items are reused and trimmed.
+    std::vector<std::size_t> read_offsets;
+    ASSERT_TRUE(mpack_cpp::ReadBatch(buffer, after, mpack_cpp::BatchFormat::kConcatenated,
+                                     &read_offsets));
+    EXPECT_EQ(after, records);
+    EXPECT_EQ(read_offsets, write_offsets);
+}
+
+TEST(batch, array_round_trip) {
+    const auto records = MakeRecords(40);
+    std::vector<char> buffer;
+    std::vector<std::size_t> write_offsets;
+    auto n = mpack_cpp::WriteBatch(records, mpack_cpp::GrowableBuffer{buffer},
+                                   mpack_cpp::BatchFormat::kArray, &write_offsets);
+    ASSERT_GT(n, 0);
+    EXPECT_EQ(write_offsets.front(), 3);  // After the array16 header.
+
+    // The whole batch is a regular array of messages.
+    std::vector<Record> as_vector;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(as_vector, buffer, n));
+    EXPECT_EQ(as_vector, records);
+
+    std::vector<Record> after;
+    std::vector<std::size_t> read_offsets;
+    ASSERT_TRUE(mpack_cpp::ReadBatch(buffer, after, mpack_cpp::BatchFormat::kArray,
+                                     &read_offsets));
+    EXPECT_EQ(after, records);
+    EXPECT_EQ(read_offsets, write_offsets);
+}
+
+TEST(batch, appends_to_container) {
+    const auto records = MakeRecords(3);
+    std::vector<char> buffer{'a', 'b'};
+    auto n = mpack_cpp::WriteBatch(records, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(buffer.size(), n + 2);
+
+    std::vector<Record> after;
+    ASSERT_TRUE(mpack_cpp::ReadBatch(buffer.data() + 2, n, after));
+    EXPECT_EQ(after, records);
+}
+
+TEST(batch, truncated_batch) {
+    const auto records = MakeRecords(10);
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteBatch(records, mpack_cpp::GrowableBuffer{buffer});
+
+    std::vector<Record> after;
+    EXPECT_FALSE(mpack_cpp::ReadBatch(buffer.data(), n - 1, after));
+}
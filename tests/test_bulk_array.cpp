@@ -0,0 +1,178 @@
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+constexpr std::size_t BUFFER_SIZE{1024};
+
+/** Reference encoding with one mpack call per element. */
+template <typename T>
+std::vector<char> EncodePerElement(const std::vector<T>& values,
+                                   void (*write)(mpack_writer_t*, T)) {
+    std::vector<char> buffer(values.size() * 9 + 5);
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer.data(), buffer.size());
+    mpack_start_array(&writer, static_cast<std::uint32_t>(values.size()));
+    for (auto value : values) {
+        write(&writer, value);
+    }
+    mpack_finish_array(&writer);
+    buffer.resize(mpack_writer_buffer_used(&writer));
+    EXPECT_EQ(mpack_writer_destroy(&writer), mpack_ok);
+    return buffer;
+}
+
+std::vector<std::int64_t> MixedIntegers() {
+    std::vector<std::int64_t> values;
+    for (std::int64_t base : {std::int64_t{1}, std::int64_t{-1}}) {
+        for (std::int64_t v : {0LL, 5LL, 31LL, 32LL, 33LL, 127LL, 128LL, 255LL, 256LL,
+                               32767LL, 65535LL, 65536LL, 2147483647LL, 4294967295LL,
+                               4294967296LL}) {
+            values.push_back(base * v);
+        }
+    }
+    values.push_back(std::numeric_limits<std::int64_t>::min());
+    values.push_back(std::numeric_limits<std::int64_t>::max());
+    return values;
+}
+
+struct Samples {
+    std::vector<double> values;
+    std::vector<std::int32_t> counts;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "values", mpack_cpp::Packed{values});
+        mpack_cpp::WriteField(writer, "counts", mpack_cpp::Packed{counts});
+    }
+
+    void from_message_pack(mpack_cpp::ReadCtx& node) {
+        mpack_cpp::ReadField(node, "values", mpack_cpp::Packed{values});
+        mpack_cpp::ReadField(node, "counts", mpack_cpp::Packed{counts});
+    }
+
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {
+        mpack_cpp::expect::ReadField(reader, "values", mpack_cpp::Packed{values});
+        mpack_cpp::expect::ReadField(reader, "counts", mpack_cpp::Packed{counts});
+    }
+};
+}  // namespace
+
+TEST(bulk_array, integers_same_bytes_as_per_element) {
+    const auto values = MixedIntegers();
+    const auto expected = EncodePerElement<std::int64_t>(values, mpack_write_i64);
+
+    std::vector<char> buffer(BUFFER_SIZE);
+    auto n = mpack_cpp::WriteToMsgPack(values, buffer);
+    buffer.resize(n);
+    EXPECT_EQ(buffer, expected);
+
+    std::vector<std::int64_t> after;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, values);
+}
+
+TEST(bulk_array, doubles_across_flushes) {
+    // Large enough to grow the writer buffer several times while encoding.
+    std::vector<double> values(10000);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<double>(i) * -0.5;
+    }
+    const auto expected = EncodePerElement<double>(values, mpack_write_double);
+
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(values, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(n, expected.size());
+    EXPECT_EQ(buffer, expected);
+}
+
+TEST(bulk_array, std_array_same_bytes_as_vector) {
+    std::array<float, 4> arr{1.0f, -2.5f, 3.25f, 0.0f};
+    std::vector<float> vec{arr.begin(), arr.end()};
+
+    std::vector<char> from_array;
+    std::vector<char> from_vector;
+    mpack_cpp::WriteToMsgPack(arr, mpack_cpp::GrowableBuffer{from_array});
+    mpack_cpp::WriteToMsgPack(vec, mpack_cpp::GrowableBuffer{from_vector});
+    EXPECT_EQ(from_array.size(), 1 + 4 * 5);
+    EXPECT_EQ(from_array, from_vector);
+}
+
+TEST(bulk_array, packed_round_trip) {
+    Samples before{{1.5, -2.25, 1e300}, {1, -1, 70000, -70000}};
+    std::vector<char> buffer(BUFFER_SIZE);
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    // map, 2 keys, bin8 headers and raw little-endian data.
+    EXPECT_EQ(n, 1 + 7 + 2 + 3 * 8 + 7 + 2 + 4 * 4);
+
+    Samples after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.values, before.values);
+    EXPECT_EQ(after.counts, before.counts);
+
+    Samples after_expect{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after_expect, buffer, n));
+    EXPECT_EQ(after_expect.values, before.values);
+    EXPECT_EQ(after_expect.counts, before.counts);
+}
+
+TEST(bulk_array, expect_reader_integers) {
+    const auto values = MixedIntegers();
+    std::vector<char> buffer(BUFFER_SIZE);
+    auto n = mpack_cpp::WriteToMsgPack(values, buffer);
+
+    std::vector<std::int64_t> after;
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, values);
+}
+
+TEST(bulk_array, out_of_range_integer) {
+    std::vector<std::int32_t> before{1, 2, 70000};
+    std::vector<char> buffer(BUFFER_SIZE);
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+
+    std::vector<std::int16_t> after;
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+}
+
+TEST(bulk_array, mixed_types_use_mpack_conversion) {
+    // Integers are accepted as doubles by mpack, the bulk path must not reject them.
+    std::vector<char> buffer(BUFFER_SIZE);
+    mpack_writer_t writer;
+    mpack_writer_init(&writer, buffer.data(), buffer.size());
+    mpack_start_array(&writer, 3);
+    mpack_write_double(&writer, 0.5);
+    mpack_write_int(&writer, -3);
+    mpack_write_float(&writer, 2.0f);
+    mpack_finish_array(&writer);
+    auto n = mpack_writer_buffer_used(&writer);
+    ASSERT_EQ(mpack_writer_destroy(&writer), mpack_ok);
+
+    std::vector<double> after;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, (std::vector<double>{0.5, -3.0, 2.0}));
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, (std::vector<double>{0.5, -3.0, 2.0}));
+}
+
+TEST(bulk_array, std_array_round_trip) {
+    std::array<std::uint16_t, 3> before{1, 300, 65535};
+    std::vector<char> buffer(BUFFER_SIZE);
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+
+    std::array<std::uint16_t, 3> after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, before);
+    after = {};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, before);
+
+    std::array<std::uint16_t, 2> wrong_size{};
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(wrong_size, buffer, n));
+}
@@ -3,11 +3,13 @@
 #include <cstdio>
 #include <memory_resource>
 #include <optional>
+#include <string>
 #include <variant>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
 #include "mpack_cpp/mpack_reader.hpp"
 #include "mpack_cpp/mpack_writer.hpp"
 
@@ -88,4 +90,85 @@ TEST(custom_allocator, string_and_vector) {
         EXPECT_EQ(after.animals.at(i).name, before.animals.at(i).name);
         EXPECT_EQ(after.animals.at(i).age, before.animals.at(i).age);
     }
-}
\ No newline at end of file
+}
+namespace {
+
+// Allocator-aware struct, decoded elements are constructed with the arena.
+struct Pet {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    std::pmr::string name;
+    std::optional<std::pmr::string> owner;
+    std::vector<std::pmr::string> tags;
+    MPACK_CPP_DEFINE(Pet, name, owner, tags)
+
+    explicit Pet(const allocator_type& alloc = {}) : name(alloc) {}
+    Pet(const Pet& other, const allocator_type& alloc)
+        : name(other.name, alloc), owner(other.owner), tags(other.tags) {}
+    Pet(Pet&& other, const allocator_type& alloc)
+        : name(std::move(other.name), alloc),
+          owner(std::move(other.owner)),
+          tags(std::move(other.tags)) {}
+};
+
+struct Shelter {
+    std::pmr::vector<Pet> pets;
+    MPACK_CPP_DEFINE(Shelter, pets)
+
+    explicit Shelter(std::pmr::memory_resource* resource) : pets(resource) {}
+};
+
+}  // namespace
+
+TEST(custom_allocator, decode_into_arena) {
+    std::pmr::monotonic_buffer_resource source_arena{std::pmr::new_delete_resource()};
+    Shelter before{&source_arena};
+    before.pets.emplace_back().name = "a dog with a rather long name";
+    before.pets.back().owner = "an owner with a rather long name";
+    before.pets.back().tags = {"a tag that does not fit in place", "short"};
+    before.pets.emplace_back().name = "cat";
+
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, 0);
+
+    std::pmr::monotonic_buffer_resource arena{std::pmr::new_delete_resource()};
+    Shelter after{&arena};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n, &arena));
+    ASSERT_EQ(after.pets.size(), 2);
+    EXPECT_EQ(after.pets[0].name, before.pets[0].name);
+    EXPECT_EQ(after.pets[0].owner, before.pets[0].owner);
+    EXPECT_EQ(after.pets[0].tags, before.pets[0].tags);
+    EXPECT_EQ(after.pets[1].name, "cat");
+    EXPECT_FALSE(after.pets[1].owner.has_value());
+
+    // Everything the decoder created uses the arena, without a default resource swap.
+    for (const auto& pet : after.pets) {
+        EXPECT_EQ(pet.name.get_allocator().resource(), &arena);
+    }
+    EXPECT_EQ(after.pets[0].owner->get_allocator().resource(), &arena);
+    for (const auto& tag : after.pets[0].tags) {
+        EXPECT_EQ(tag.get_allocator().resource(), &arena);
+    }
+}
+
+TEST(custom_allocator, decoder_into_arena) {
+    std::pmr::monotonic_buffer_resource source_arena{std::pmr::new_delete_resource()};
+    Shelter before{&source_arena};
+    before.pets.emplace_back().name = "a dog with a rather long name";
+    before.pets.back().tags = {"a tag that does not fit in place"};
+
+    std::vector<std::uint8_t> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, 0);
+
+    // The buffer overloads pass the resource on as well.
+    mpack_cpp::Decoder decoder;
+    std::pmr::monotonic_buffer_resource arena{std::pmr::new_delete_resource()};
+    Shelter after{&arena};
+    ASSERT_TRUE(decoder.Read(after, buffer, n, &arena));
+    ASSERT_EQ(after.pets.size(), 1);
+    EXPECT_EQ(after.pets[0].name, before.pets[0].name);
+    ASSERT_EQ(after.pets[0].tags.size(), 1);
+    EXPECT_EQ(after.pets[0].tags[0].get_allocator().resource(), &arena);
+}
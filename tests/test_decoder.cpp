@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+constexpr std::size_t BUFFER_SIZE{1024};
+
+struct Animal {
+    std::string name;
+    int age;
+    MPACK_CPP_DEFINE(Animal, name, age)
+};
+
+struct Zoo {
+    std::vector<Animal> animals;
+    MPACK_CPP_DEFINE(Zoo, animals)
+};
+}  // namespace
+
+TEST(decoder, reuse_pool_across_messages) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    Zoo before{{Animal{"dog", 11}, Animal{"cat", 5}}};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+
+    mpack_cpp::Decoder decoder;
+    for (int i = 0; i < 3; ++i) {
+        Zoo after{};
+        ASSERT_TRUE(decoder.Read(after, buffer, n));
+        ASSERT_EQ(after.animals.size(), before.animals.size());
+        EXPECT_EQ(after.animals.at(1).name, "cat");
+        EXPECT_EQ(after.animals.at(1).age, 5);
+    }
+    // root map, key, array, 2 x (map, 2 x key, 2 x value)
+    EXPECT_EQ(decoder.high_water_mark(), 13);
+    EXPECT_EQ(decoder.pool_size(), mpack_cpp::Decoder::kDefaultPoolSize);
+}
+
+TEST(decoder, grow_pool_when_needed) {
+    Zoo before{};
+    for (int i = 0; i < 20; ++i) {
+        before.animals.push_back(Animal{"animal", i});
+    }
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+
+    mpack_cpp::Decoder decoder{4};
+    Zoo after{};
+    ASSERT_TRUE(decoder.Read(after, buffer, n));
+    ASSERT_EQ(after.animals.size(), before.animals.size());
+    EXPECT_EQ(after.animals.at(19).age, 19);
+    EXPECT_EQ(decoder.high_water_mark(), 3 + 20 * 5);
+    EXPECT_GE(decoder.pool_size(), decoder.high_water_mark());
+
+    // A second, smaller message fits in the grown pool.
+    auto pool_size = decoder.pool_size();
+    before.animals.resize(2);
+    n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_TRUE(decoder.Read(after, buffer.data() + buffer.size() - n, n));
+    EXPECT_EQ(after.animals.size(), 2);
+    EXPECT_EQ(decoder.pool_size(), pool_size);
+}
+
+TEST(decoder, invalid_data) {
+    std::vector<char> buffer{'\xc1'};  // Never used type.
+    mpack_cpp::Decoder decoder{4};
+    Zoo after{};
+    EXPECT_FALSE(decoder.Read(after, buffer, buffer.size()));
+}
@@ -0,0 +1,84 @@
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Position {
+    std::uint64_t timestamp;
+    std::int32_t x;
+    double y;
+    bool valid;
+    std::array<std::uint16_t, 3> flags;
+    std::optional<std::uint8_t> quality;
+    MPACK_CPP_DEFINE(Position, timestamp, x, y, valid, flags, quality)
+};
+
+struct Track {
+    std::string name;
+    std::vector<Position> positions;
+    MPACK_CPP_DEFINE(Track, name, positions)
+};
+
+// A custom writer, so sizing it fills builder pages past the scratch buffer.
+struct Labels {
+    std::vector<std::string> labels;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "labels", labels);
+    }
+};
+
+Position LargestPosition() {
+    return {std::numeric_limits<std::uint64_t>::max(),
+            std::numeric_limits<std::int32_t>::min(),
+            1.5,
+            true,
+            {0xffff, 0xffff, 0xffff},
+            std::uint8_t{0xff}};
+}
+}  // namespace
+
+TEST(encoded_size, matches_encoding) {
+    Track track{"track", {LargestPosition(), Position{1, 2, 3.0, false, {}, {}}}};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(track, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(mpack_cpp::EncodedSize(track), n);
+
+    // Larger than the scratch buffer and going through the map builder.
+    Labels labels{std::vector<std::string>(100, std::string(50, 'l'))};
+    buffer.clear();
+    n = mpack_cpp::WriteToMsgPack(labels, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(mpack_cpp::EncodedSize(labels), n);
+}
+
+TEST(encoded_size, exact_allocation) {
+    Track track{"exact", std::vector<Position>(10, LargestPosition())};
+    std::vector<char> buffer(mpack_cpp::EncodedSize(track));
+    EXPECT_EQ(mpack_cpp::WriteToMsgPack(track, buffer), buffer.size());
+
+    Track after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, buffer.size()));
+    EXPECT_EQ(after.positions.size(), 10);
+}
+
+TEST(encoded_size, max_encoded_size) {
+    // fixmap, then every key (header and characters) with its widest value.
+    constexpr std::size_t kExpected{1 + (10 + 9) + (2 + 5) + (2 + 9) + (6 + 1) +
+                                    (6 + 1 + 3 * 3) + (8 + 2)};
+    static_assert(mpack_cpp::MaxEncodedSize<Position>() == kExpected);
+    static_assert(mpack_cpp::MaxEncodedSize<std::array<Position, 2>>() ==
+                  1 + 2 * kExpected);
+
+    // The bound is reached when every field takes its widest encoding.
+    std::array<char, mpack_cpp::MaxEncodedSize<Position>()> slot{};
+    EXPECT_EQ(mpack_cpp::WriteToMsgPack(LargestPosition(), slot.data(), slot.size()),
+              kExpected);
+}
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <optional>
@@ -260,3 +261,50 @@ TEST(mpack_expect_reader, try_different_buffer_overloads) {
         EXPECT_EQ(before, after);
     }
 }
+
+namespace {
+struct Tagged {
+    std::array<char, 2> tag;
+    std::optional<std::int32_t> gain;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteExtField(writer, "tag", 7, tag);
+        mpack_cpp::WriteOptionalField(writer, "gain", gain);
+    }
+
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {
+        std::int8_t type{0};
+        mpack_cpp::expect::ReadExtField(reader, "tag", type, tag);
+        mpack_cpp::expect::ReadOptionalField(reader, "gain", gain);
+    }
+};
+
+// The outer `gain` directly follows the inner map, which ends with an ext field.
+struct Outer {
+    Tagged inner;
+    std::optional<std::int32_t> gain;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "inner", inner);
+        mpack_cpp::WriteOptionalField(writer, "gain", gain);
+    }
+
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {
+        mpack_cpp::expect::ReadField(reader, "inner", inner);
+        mpack_cpp::expect::ReadOptionalField(reader, "gain", gain);
+    }
+};
+}  // namespace
+
+TEST(mpack_expect_reader, ext_field_then_absent_optional) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    Outer before{{{'a', 'b'}, std::nullopt}, 5};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    ASSERT_GT(n, 0);
+
+    Outer after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.inner.tag, before.inner.tag);
+    EXPECT_FALSE(after.inner.gain.has_value());
+    EXPECT_EQ(after.gain, 5);
+}
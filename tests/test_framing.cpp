@@ -0,0 +1,202 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_framing.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+
+namespace {
+struct Event {
+    std::uint32_t sequence;
+    std::string text;
+    MPACK_CPP_DEFINE(Event, sequence, text)
+};
+
+// Encoded size is bounded at compile time.
+struct Ping {
+    std::uint32_t sequence;
+    MPACK_CPP_DEFINE(Ping, sequence)
+};
+
+std::vector<Event> MakeEvents() {
+    return {{1, "short"}, {2, std::string(300, 'y')}, {3, ""}, {4, "last"}};
+}
+
+void ExpectFrames(mpack_cpp::FrameDecoder& decoder, const std::vector<Event>& events,
+                  std::size_t& next) {
+    mpack_cpp::BytesView frame;
+    while (decoder.Next(frame)) {
+        ASSERT_LT(next, events.size());
+        Event event{};
+        ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(event, frame.data, frame.size));
+        EXPECT_EQ(event.sequence, events[next].sequence);
+        EXPECT_EQ(event.text, events[next].text);
+        ++next;
+    }
+}
+}  // namespace
+
+TEST(framing, prefix_encoding) {
+    // The bound of a `Ping` is below 128 bytes, a one byte varint.
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteFrame(Ping{7}, mpack_cpp::GrowableBuffer{buffer},
+                                   mpack_cpp::FramePrefix::kVarint);
+    ASSERT_EQ(n, buffer.size());
+    EXPECT_EQ(static_cast<std::size_t>(buffer[0]), n - 1);
+
+    // Unbounded types get a varint padded to 5 bytes.
+    buffer.clear();
+    Event event{7, "x"};
+    n = mpack_cpp::WriteFrame(event, mpack_cpp::GrowableBuffer{buffer},
+                              mpack_cpp::FramePrefix::kVarint);
+    ASSERT_EQ(n, buffer.size());
+    EXPECT_EQ(static_cast<std::size_t>(static_cast<std::uint8_t>(buffer[0])),
+              0x80 | (n - 5));
+    EXPECT_EQ(static_cast<std::uint8_t>(buffer[1]), 0x80);
+    EXPECT_EQ(static_cast<std::uint8_t>(buffer[2]), 0x80);
+    EXPECT_EQ(static_cast<std::uint8_t>(buffer[3]), 0x80);
+    EXPECT_EQ(buffer[4], 0);
+    mpack_cpp::FrameDecoder decoder(mpack_cpp::FramePrefix::kVarint);
+    decoder.Feed(buffer.data(), buffer.size());
+    mpack_cpp::BytesView frame;
+    ASSERT_TRUE(decoder.Next(frame));
+    EXPECT_EQ(frame.size, n - 5);
+
+    buffer.clear();
+    n = mpack_cpp::WriteFrame(event, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_EQ(n, buffer.size());
+    EXPECT_EQ(buffer[0], 0);
+    EXPECT_EQ(buffer[1], 0);
+    EXPECT_EQ(buffer[2], 0);
+    EXPECT_EQ(static_cast<std::size_t>(buffer[3]), n - 4);
+}
+
+TEST(framing, byte_by_byte) {
+    const auto events = MakeEvents();
+    using mpack_cpp::FramePrefix;
+    for (auto prefix : {FramePrefix::kFixed32, FramePrefix::kVarint}) {
+        std::vector<char> stream;
+        for (const auto& event : events) {
+            mpack_cpp::GrowableBuffer sink{stream};
+            ASSERT_GT(mpack_cpp::WriteFrame(event, sink, prefix), 0);
+        }
+
+        mpack_cpp::FrameDecoder decoder(prefix);
+        std::size_t next{0};
+        for (char byte : stream) {
+            decoder.Feed(&byte, 1);
+            ExpectFrames(decoder, events, next);
+        }
+        EXPECT_EQ(next, events.size());
+        EXPECT_EQ(decoder.buffered(), 0);
+        EXPECT_FALSE(decoder.error());
+    }
+}
+
+TEST(framing, non_blocking_file_descriptor) {
+    const auto events = MakeEvents();
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+
+    mpack_cpp::FrameDecoder decoder(mpack_cpp::FramePrefix::kVarint);
+    mpack_cpp::FileDescriptor reader{fds[0]};
+    EXPECT_EQ(decoder.ReadFrom(reader), mpack_cpp::FrameDecoder::Status::kOpen);
+
+    std::vector<char> scratch;
+    std::size_t next{0};
+    for (const auto& event : events) {
+        ASSERT_GT(mpack_cpp::WriteFrame(event, mpack_cpp::FileDescriptor{fds[1]}, scratch,
+                                        mpack_cpp::FramePrefix::kVarint),
+                  0);
+        EXPECT_EQ(decoder.ReadFrom(reader, 64), mpack_cpp::FrameDecoder::Status::kOpen);
+        ExpectFrames(decoder, events, next);
+    }
+    EXPECT_EQ(next, events.size());
+
+    close(fds[1]);
+    EXPECT_EQ(decoder.ReadFrom(reader), mpack_cpp::FrameDecoder::Status::kClosed);
+    close(fds[0]);
+}
+
+TEST(framing, refuses_non_blocking_writer) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+    ASSERT_EQ(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+
+    std::vector<char> scratch;
+    EXPECT_EQ(mpack_cpp::WriteFrame(Event{1, "one"}, mpack_cpp::FileDescriptor{fds[1]},
+                                    scratch),
+              0);
+    char byte{0};
+    EXPECT_EQ(read(fds[0], &byte, 1), -1);  // Nothing was written.
+    close(fds[1]);
+    close(fds[0]);
+}
+
+TEST(framing, bounded_read_buffer) {
+    const auto events = MakeEvents();
+    std::vector<char> stream;
+    for (int i = 0; i < 10; ++i) {
+        for (const auto& event : events) {
+            mpack_cpp::WriteFrame(event, mpack_cpp::GrowableBuffer{stream});
+        }
+    }
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+    ASSERT_EQ(write(fds[1], stream.data(), stream.size()),
+              static_cast<ssize_t>(stream.size()));
+    close(fds[1]);
+
+    // Every frame fits, but all of them together do not.
+    const std::size_t max_frame_size{400};
+    mpack_cpp::FrameDecoder decoder(mpack_cpp::FramePrefix::kFixed32, max_frame_size);
+    mpack_cpp::FileDescriptor reader{fds[0]};
+    std::size_t next{0};
+    std::size_t full{0};
+    auto status = mpack_cpp::FrameDecoder::Status::kFull;
+    while (status != mpack_cpp::FrameDecoder::Status::kClosed) {
+        status = decoder.ReadFrom(reader, 64);
+        ASSERT_NE(status, mpack_cpp::FrameDecoder::Status::kError);
+        EXPECT_LE(decoder.buffered(), max_frame_size + 5);
+        full += status == mpack_cpp::FrameDecoder::Status::kFull ? 1 : 0;
+        mpack_cpp::BytesView frame;
+        while (decoder.Next(frame)) {
+            Event event{};
+            ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(event, frame.data, frame.size));
+            EXPECT_EQ(event.sequence, events[next % events.size()].sequence);
+            ++next;
+        }
+    }
+    EXPECT_GT(full, 0);
+    EXPECT_EQ(next, 10 * events.size());
+    close(fds[0]);
+}
+
+TEST(framing, oversized_frame) {
+    std::vector<char> stream;
+    Event event{1, std::string(100, 'z')};
+    mpack_cpp::WriteFrame(event, mpack_cpp::GrowableBuffer{stream});
+
+    mpack_cpp::FrameDecoder decoder(mpack_cpp::FramePrefix::kFixed32, 64);
+    decoder.Feed(stream.data(), stream.size());
+    mpack_cpp::BytesView frame;
+    EXPECT_FALSE(decoder.Next(frame));
+    EXPECT_TRUE(decoder.error());
+}
+
+TEST(framing, malformed_varint) {
+    const char prefix[] = {'\xff', '\xff', '\xff', '\xff', '\xff', '\x01'};
+    mpack_cpp::FrameDecoder decoder(mpack_cpp::FramePrefix::kVarint);
+    decoder.Feed(prefix, sizeof(prefix));
+    mpack_cpp::BytesView frame;
+    EXPECT_FALSE(decoder.Next(frame));
+    EXPECT_TRUE(decoder.error());
+}
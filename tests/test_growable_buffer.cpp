@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+constexpr std::size_t BUFFER_SIZE{1024};
+
+struct Animal {
+    std::string name;
+    int age;
+    MPACK_CPP_DEFINE(Animal, name, age)
+};
+
+struct Zoo {
+    std::vector<Animal> animals;
+    MPACK_CPP_DEFINE(Zoo, animals)
+};
+}  // namespace
+
+TEST(growable_buffer, same_bytes_as_fixed_buffer) {
+    Zoo before{{Animal{"dog", 11}, Animal{"cat", 5}}};
+
+    std::vector<char> fixed(BUFFER_SIZE);
+    auto n_fixed = mpack_cpp::WriteToMsgPack(before, fixed);
+    fixed.resize(n_fixed);
+
+    std::vector<char> growable;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{growable});
+    EXPECT_EQ(n, n_fixed);
+    EXPECT_EQ(growable.size(), n);
+    EXPECT_EQ(growable, fixed);
+}
+
+TEST(growable_buffer, grows_beyond_initial_size) {
+    Zoo before{};
+    for (int i = 0; i < 500; ++i) {
+        before.animals.push_back(Animal{"animal_" + std::to_string(i), i});
+    }
+
+    std::vector<std::uint8_t> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, BUFFER_SIZE);
+    EXPECT_EQ(buffer.size(), n);
+
+    Zoo after{};
+    bool success = mpack_cpp::ReadFromMsgPack(after, buffer, n);
+    ASSERT_TRUE(success);
+    ASSERT_EQ(after.animals.size(), before.animals.size());
+    for (std::size_t i = 0; i < after.animals.size(); ++i) {
+        EXPECT_EQ(after.animals.at(i).name, before.animals.at(i).name);
+        EXPECT_EQ(after.animals.at(i).age, before.animals.at(i).age);
+    }
+}
+
+TEST(growable_buffer, appends_to_existing_content) {
+    std::pmr::monotonic_buffer_resource arena{};
+    std::pmr::vector<char> buffer{{'x', 'y'}, &arena};
+
+    std::string first{"hello"};
+    std::string second(300, 'a');
+    auto n1 = mpack_cpp::WriteToMsgPack(first, mpack_cpp::GrowableBuffer{buffer});
+    auto n2 = mpack_cpp::WriteToMsgPack(second, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(n1, 6);
+    EXPECT_EQ(n2, 303);
+    ASSERT_EQ(buffer.size(), 2 + n1 + n2);
+    EXPECT_EQ(buffer.at(0), 'x');
+    EXPECT_EQ(buffer.at(1), 'y');
+
+    std::string after;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer.data() + 2, n1));
+    EXPECT_EQ(after, first);
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer.data() + 2 + n1, n2));
+    EXPECT_EQ(after, second);
+}
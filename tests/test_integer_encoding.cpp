@@ -0,0 +1,80 @@
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Wide {
+    std::uint64_t u;
+    std::int64_t i;
+    MPACK_CPP_DEFINE(Wide, u, i)
+};
+
+struct Narrow {
+    std::uint8_t u;
+    std::int8_t i;
+    MPACK_CPP_DEFINE(Narrow, u, i)
+};
+
+struct ExpectNarrow {
+    std::uint8_t u;
+    std::int8_t i;
+    MPACK_CPP_EXPECT_DEFINE(ExpectNarrow, u, i)
+};
+
+std::size_t EncodedSize(std::uint64_t value) {
+    std::vector<char> buffer;
+    return mpack_cpp::WriteToMsgPack(value, mpack_cpp::GrowableBuffer{buffer});
+}
+
+std::size_t EncodedSize(std::int64_t value) {
+    std::vector<char> buffer;
+    return mpack_cpp::WriteToMsgPack(value, mpack_cpp::GrowableBuffer{buffer});
+}
+}  // namespace
+
+TEST(integer_encoding, smallest_encoding_for_value) {
+    EXPECT_EQ(EncodedSize(std::uint64_t{5}), 1);  // positive fixint
+    EXPECT_EQ(EncodedSize(std::uint64_t{200}), 2);
+    EXPECT_EQ(EncodedSize(std::uint64_t{300}), 3);
+    EXPECT_EQ(EncodedSize(std::uint64_t{70000}), 5);
+    EXPECT_EQ(EncodedSize(std::numeric_limits<std::uint64_t>::max()), 9);
+
+    EXPECT_EQ(EncodedSize(std::int64_t{-1}), 1);  // negative fixint
+    EXPECT_EQ(EncodedSize(std::int64_t{-100}), 2);
+    EXPECT_EQ(EncodedSize(std::int64_t{-200}), 3);
+    EXPECT_EQ(EncodedSize(std::numeric_limits<std::int64_t>::min()), 9);
+}
+
+TEST(integer_encoding, wide_fields_decode_into_narrow_fields) {
+    Wide before{5, -1};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_EQ(n, 7);  // fixmap, two fixstr keys and two fixint values
+
+    Narrow node{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(node, buffer.data(), n));
+    EXPECT_EQ(node.u, 5);
+    EXPECT_EQ(node.i, -1);
+
+    ExpectNarrow expect{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(expect, buffer.data(), n));
+    EXPECT_EQ(expect.u, 5);
+    EXPECT_EQ(expect.i, -1);
+}
+
+TEST(integer_encoding, out_of_range_values_are_rejected) {
+    Wide before{300, -200};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+
+    Narrow node{};
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(node, buffer.data(), n));
+    ExpectNarrow expect{};
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(expect, buffer.data(), n));
+}
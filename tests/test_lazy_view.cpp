@@ -0,0 +1,155 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_lazy.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Route {
+    std::string destination;
+    std::uint16_t priority;
+    MPACK_CPP_DEFINE(Route, destination, priority)
+};
+
+struct Order {
+    std::uint64_t id;
+    std::string symbol;
+    double price;
+    std::vector<std::int32_t> quantities;
+    std::optional<std::string> note;
+    Route route;
+    MPACK_CPP_DEFINE(Order, id, symbol, price, quantities, note, route)
+};
+
+// Older version of `Order`, without the `note` and `route` members.
+struct OrderV1 {
+    std::uint64_t id;
+    std::string symbol;
+    double price;
+    std::vector<std::int32_t> quantities;
+    MPACK_CPP_DEFINE(OrderV1, id, symbol, price, quantities)
+};
+
+Order MakeOrder() {
+    return {42, "ACME", 12.5, {100, -20, 3}, std::nullopt, {"desk-7", 3}};
+}
+
+std::vector<char> Encode(const Order& order) {
+    std::vector<char> buffer;
+    EXPECT_GT(mpack_cpp::WriteToMsgPack(order, mpack_cpp::GrowableBuffer{buffer}), 0);
+    return buffer;
+}
+}  // namespace
+
+TEST(lazy_view, reads_single_members) {
+    for (auto index : {mpack_cpp::LazyIndex::kCached, mpack_cpp::LazyIndex::kNone}) {
+        auto buffer = Encode(MakeOrder());
+        mpack_cpp::LazyView<Order> view(buffer.data(), buffer.size(), index);
+        EXPECT_TRUE(view.valid());
+
+        std::string symbol;
+        ASSERT_TRUE(view.Read<&Order::symbol>(symbol));
+        EXPECT_EQ(symbol, "ACME");
+        double price{0};
+        ASSERT_TRUE(view.Read<&Order::price>(price));
+        EXPECT_EQ(price, 12.5);
+        std::vector<std::int32_t> quantities;
+        ASSERT_TRUE(view.Read<&Order::quantities>(quantities));
+        EXPECT_EQ(quantities, (std::vector<std::int32_t>{100, -20, 3}));
+        std::uint64_t id{0};
+        ASSERT_TRUE(view.Read<&Order::id>(id));
+        EXPECT_EQ(id, 42);
+    }
+}
+
+TEST(lazy_view, nested_view) {
+    auto buffer = Encode(MakeOrder());
+    mpack_cpp::LazyView<Order> view(buffer.data(), buffer.size());
+
+    auto route = view.View<&Order::route>();
+    std::string destination;
+    ASSERT_TRUE(route.Read<&Route::destination>(destination));
+    EXPECT_EQ(destination, "desk-7");
+    std::uint16_t priority{0};
+    ASSERT_TRUE(route.Read<&Route::priority>(priority));
+    EXPECT_EQ(priority, 3);
+}
+
+TEST(lazy_view, optional_and_missing_members) {
+    auto order = MakeOrder();
+    order.note = "urgent";
+    auto buffer = Encode(order);
+    mpack_cpp::LazyView<Order> view(buffer.data(), buffer.size());
+    std::optional<std::string> note;
+    ASSERT_TRUE(view.Read<&Order::note>(note));
+    EXPECT_EQ(note, "urgent");
+
+    // Encoded by an older version, the optional member is reset, the required
+    // member is an error.
+    OrderV1 old_order{7, "ACME", 1.0, {}};
+    std::vector<char> old_buffer;
+    ASSERT_GT(mpack_cpp::WriteToMsgPack(old_order, mpack_cpp::GrowableBuffer{old_buffer}),
+              0);
+    mpack_cpp::LazyView<Order> old_view(old_buffer.data(), old_buffer.size());
+    ASSERT_TRUE(old_view.Read<&Order::note>(note));
+    EXPECT_FALSE(note.has_value());
+    Route route;
+    EXPECT_FALSE(old_view.Read<&Order::route>(route));
+    EXPECT_FALSE(old_view.View<&Order::route>().valid());
+}
+
+TEST(lazy_view, raw_values_point_into_buffer) {
+    auto buffer = Encode(MakeOrder());
+    mpack_cpp::LazyView<Order> view(buffer.data(), buffer.size());
+
+    mpack_cpp::BytesView value;
+    ASSERT_EQ(view.Find("route", value), mpack_cpp::LazyFind::kFound);
+    EXPECT_GE(value.data, buffer.data());
+    EXPECT_LE(value.data + value.size, buffer.data() + buffer.size());
+    Route route;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(route, value.data, value.size));
+    EXPECT_EQ(route.destination, "desk-7");
+
+    EXPECT_EQ(view.Find("unknown", value), mpack_cpp::LazyFind::kMissing);
+    std::string symbol;
+    ASSERT_TRUE(view.Read("symbol", symbol));
+    EXPECT_EQ(symbol, "ACME");
+}
+
+TEST(lazy_view, malformed_buffers) {
+    auto buffer = Encode(MakeOrder());
+    for (auto index : {mpack_cpp::LazyIndex::kCached, mpack_cpp::LazyIndex::kNone}) {
+        // The route is the last member, so it is cut off.
+        mpack_cpp::LazyView<Order> truncated(buffer.data(), buffer.size() - 1, index);
+        EXPECT_FALSE(truncated.valid());
+        Route route;
+        EXPECT_FALSE(truncated.Read<&Order::route>(route));
+        mpack_cpp::BytesView value;
+        EXPECT_EQ(truncated.Find("route", value), mpack_cpp::LazyFind::kMalformed);
+
+        // Only the map header is left, not the same as a missing optional member.
+        mpack_cpp::LazyView<Order> header_only(buffer.data(), 1, index);
+        std::optional<std::string> note{"keep"};
+        EXPECT_FALSE(header_only.Read<&Order::note>(note));
+        EXPECT_FALSE(header_only.Read("note", note));
+
+        // The view on a member that could not be found is empty.
+        auto empty = truncated.View<&Order::route>();
+        EXPECT_FALSE(empty.valid());
+        std::string destination;
+        EXPECT_FALSE(empty.Read<&Route::destination>(destination));
+        std::optional<std::string> any;
+        EXPECT_FALSE(empty.Read("destination", any));
+    }
+
+    std::vector<char> array{'\x92', '\x01', '\x02'};
+    mpack_cpp::LazyView<Order> not_a_map(array.data(), array.size());
+    std::uint64_t id{0};
+    EXPECT_FALSE(not_a_map.Read<&Order::id>(id));
+}
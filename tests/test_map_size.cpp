@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+using testing::ElementsAre;
+
+namespace {
+struct Point {
+    std::int8_t x;
+    std::int8_t y;
+    std::optional<std::int8_t> z;
+    MPACK_CPP_DEFINE(Point, x, y, z)
+};
+
+// Same layout, but without a map size so it goes through the map builder.
+struct ManualPoint {
+    std::int8_t x;
+    std::int8_t y;
+    std::optional<std::int8_t> z;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "x", x);
+        mpack_cpp::WriteField(writer, "y", y);
+        mpack_cpp::WriteOptionalField(writer, "z", z);
+    }
+};
+
+struct Path {
+    std::string name;
+    std::vector<Point> points;
+    MPACK_CPP_DEFINE(Path, name, points)
+};
+
+struct ManualPath {
+    std::string name;
+    std::vector<ManualPoint> points;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "name", name);
+        mpack_cpp::WriteField(writer, "points", points);
+    }
+};
+
+std::vector<char> Encode(const Path& path) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(path, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+
+std::vector<char> Encode(const ManualPath& path) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(path, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+}  // namespace
+
+TEST(map_size, counts_present_optionals) {
+    EXPECT_EQ((Point{1, 2, std::nullopt}.message_pack_map_size()), 2);
+    EXPECT_EQ((Point{1, 2, 3}.message_pack_map_size()), 3);
+    EXPECT_EQ((Path{"a", {}}.message_pack_map_size()), 2);
+}
+
+TEST(map_size, header_written_up_front) {
+    std::vector<char> buffer;
+    Point point{1, 2, std::nullopt};
+    mpack_cpp::WriteToMsgPack(point, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_THAT(buffer, ElementsAre(0x82, 0xA1, 'x', 0x01, 0xA1, 'y', 0x02));
+}
+
+TEST(map_size, same_bytes_as_map_builder) {
+    Path path{"route", {{1, 2, std::nullopt}, {3, 4, 5}, {-6, 7, std::nullopt}}};
+    ManualPath manual{"route", {{1, 2, std::nullopt}, {3, 4, 5}, {-6, 7, std::nullopt}}};
+    EXPECT_EQ(Encode(path), Encode(manual));
+
+    Path after{};
+    auto buffer = Encode(path);
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, buffer.size()));
+    ASSERT_EQ(after.points.size(), 3);
+    EXPECT_EQ(after.points[1].z, std::optional<std::int8_t>{5});
+    EXPECT_EQ(after.points[2].z, std::nullopt);
+}
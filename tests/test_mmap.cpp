@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_mmap.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Archive {
+    std::string name;
+    std::vector<std::uint32_t> ids;
+    MPACK_CPP_DEFINE(Archive, name, ids)
+};
+
+struct ArchiveView {
+    std::string_view name;
+    std::vector<std::uint32_t> ids;
+    MPACK_CPP_DEFINE(ArchiveView, name, ids)
+};
+
+struct ExpectArchive {
+    std::string name;
+    std::vector<std::uint32_t> ids;
+    MPACK_CPP_EXPECT_DEFINE(ExpectArchive, name, ids)
+};
+
+/** Temporary file that is removed again at the end of the test. */
+class TempFile {
+   public:
+    explicit TempFile(const std::vector<char>& content) {
+        int fd = mkstemp(path_.data());
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(write(fd, content.data(), content.size()),
+                  static_cast<ssize_t>(content.size()));
+        close(fd);
+    }
+    ~TempFile() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+   private:
+    std::string path_{"/tmp/mpack_cpp_mmap_XXXXXX"};
+};
+
+Archive MakeArchive() {
+    Archive archive{"archive", {}};
+    for (std::uint32_t i = 0; i < 10000; ++i) {
+        archive.ids.push_back(i * 3);
+    }
+    return archive;
+}
+}  // namespace
+
+TEST(mmap, node_reader_decodes_in_place) {
+    const auto before = MakeArchive();
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    TempFile temp(buffer);
+
+    mpack_cpp::MappedMsgPackFile file(temp.path());
+    ASSERT_TRUE(file.is_open());
+    EXPECT_EQ(file.size(), buffer.size());
+
+    ArchiveView after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, file));
+    EXPECT_EQ(after.name, before.name);
+    EXPECT_EQ(after.ids, before.ids);
+    // The view points into the mapping.
+    EXPECT_GE(after.name.data(), file.data());
+    EXPECT_LT(after.name.data(), file.data() + file.size());
+}
+
+TEST(mmap, expect_reader) {
+    const auto before = MakeArchive();
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    TempFile temp(buffer);
+
+    mpack_cpp::MappedMsgPackFile file(temp.path(),
+                                      mpack_cpp::MappedMsgPackFile::Access::kRandom);
+    ExpectArchive after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, file));
+    EXPECT_EQ(after.name, before.name);
+    EXPECT_EQ(after.ids, before.ids);
+}
+
+TEST(mmap, move_keeps_mapping) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(MakeArchive(), mpack_cpp::GrowableBuffer{buffer});
+    TempFile temp(buffer);
+
+    mpack_cpp::MappedMsgPackFile first(temp.path());
+    const char* data = first.data();
+    mpack_cpp::MappedMsgPackFile second(std::move(first));
+    EXPECT_FALSE(first.is_open());
+    EXPECT_TRUE(second.is_open());
+    EXPECT_EQ(second.data(), data);
+}
+
+TEST(mmap, missing_or_empty_file) {
+    mpack_cpp::MappedMsgPackFile missing("/nonexistent/mpack_cpp.msgpack");
+    EXPECT_FALSE(missing.is_open());
+    Archive archive{};
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(archive, missing));
+
+    TempFile temp({});
+    mpack_cpp::MappedMsgPackFile empty(temp.path());
+    EXPECT_TRUE(empty.is_open());
+    EXPECT_EQ(empty.size(), 0);
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(archive, empty));
+}
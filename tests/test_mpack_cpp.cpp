@@ -260,3 +260,30 @@ TEST(mpack_cpp_to_msgpack_and_back, try_different_buffer_overloads) {
         EXPECT_EQ(before, after);
     }
 }
+
+TEST(mpack_cpp, encoded_key) {
+    constexpr auto fixstr = mpack_cpp::EncodeKey("age");
+    static_assert(fixstr.size == 4);
+    static_assert(fixstr.data[0] == static_cast<char>(0xA3) && fixstr.data[3] == 'e');
+
+    constexpr auto str8 = mpack_cpp::EncodeKey("01234567890123456789012345678901");
+    static_assert(str8.size == 34);
+    static_assert(str8.data[0] == static_cast<char>(0xD9) && str8.data[1] == 32);
+
+    // Same bytes as writing the key at runtime.
+    std::vector<char> expected(BUFFER_SIZE);
+    std::vector<char> actual(BUFFER_SIZE);
+    auto write = [](std::vector<char>& buffer, auto key) {
+        mpack_writer_t writer;
+        mpack_writer_init(&writer, buffer.data(), buffer.size());
+        mpack_start_map(&writer, 1);
+        mpack_cpp::WriteField(writer, key, true);
+        mpack_finish_map(&writer);
+        auto n = mpack_writer_buffer_used(&writer);
+        EXPECT_EQ(mpack_writer_destroy(&writer), mpack_ok);
+        buffer.resize(n);
+    };
+    write(expected, "01234567890123456789012345678901");
+    write(actual, str8);
+    EXPECT_EQ(actual, expected);
+}
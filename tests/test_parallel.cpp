@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_parallel.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Entry {
+    std::uint64_t timestamp;
+    std::string message;
+    std::vector<double> values;
+    MPACK_CPP_DEFINE(Entry, timestamp, message, values)
+
+    bool operator==(const Entry& other) const {
+        return timestamp == other.timestamp && message == other.message &&
+               values == other.values;
+    }
+};
+
+std::vector<Entry> MakeEntries(std::uint64_t count) {
+    std::vector<Entry> entries;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        entries.push_back({i * 1000, "entry " + std::to_string(i), {}});
+        for (std::uint64_t j = 0; j < i % 7; ++j) {
+            entries.back().values.push_back(static_cast<double>(i + j) / 4);
+        }
+    }
+    return entries;
+}
+}  // namespace
+
+TEST(parallel_read, matches_serial_decode) {
+    const auto entries = MakeEntries(1000);
+    std::vector<char> buffer;
+    ASSERT_GT(mpack_cpp::WriteBatch(entries, mpack_cpp::GrowableBuffer{buffer}), 0);
+
+    for (std::size_t threads : {1, 3, 8, 0}) {
+        std::vector<Entry> after;
+        ASSERT_TRUE(mpack_cpp::ParallelReadFromMsgPack(buffer, after, threads));
+        EXPECT_EQ(after, entries);
+    }
+}
+
+TEST(parallel_read, more_threads_than_messages) {
+    const auto entries = MakeEntries(2);
+    std::vector<char> buffer;
+    mpack_cpp::WriteBatch(entries, mpack_cpp::GrowableBuffer{buffer});
+
+    std::vector<Entry> after(5);
+    ASSERT_TRUE(mpack_cpp::ParallelReadFromMsgPack(buffer, after, 16));
+    EXPECT_EQ(after, entries);
+
+    std::vector<char> empty;
+    ASSERT_TRUE(mpack_cpp::ParallelReadFromMsgPack(empty, after, 4));
+    EXPECT_TRUE(after.empty());
+}
+
+TEST(parallel_read, truncated_stream) {
+    const auto entries = MakeEntries(50);
+    std::vector<char> buffer;
+    mpack_cpp::WriteBatch(entries, mpack_cpp::GrowableBuffer{buffer});
+    buffer.pop_back();
+
+    std::vector<Entry> after;
+    EXPECT_FALSE(mpack_cpp::ParallelReadFromMsgPack(buffer, after, 4));
+}
+
+TEST(parallel_read, invalid_message) {
+    // A map whose value has the wrong type is found by the decoder, not the scan.
+    const auto entries = MakeEntries(20);
+    std::vector<char> buffer;
+    mpack_cpp::WriteBatch(entries, mpack_cpp::GrowableBuffer{buffer});
+    std::vector<char> bad{static_cast<char>(0x81), static_cast<char>(0xA9)};
+    for (char c : std::string("timestamp")) {
+        bad.push_back(c);
+    }
+    bad.push_back(static_cast<char>(0xC3));  // true
+    buffer.insert(buffer.end(), bad.begin(), bad.end());
+
+    std::vector<Entry> after;
+    EXPECT_FALSE(mpack_cpp::ParallelReadFromMsgPack(buffer, after, 4));
+}
+
+namespace {
+// Allocator-aware version of `Entry`.
+struct ArenaEntry {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    std::uint64_t timestamp{0};
+    std::pmr::string message;
+    std::pmr::vector<double> values;
+    MPACK_CPP_DEFINE(ArenaEntry, timestamp, message, values)
+
+    explicit ArenaEntry(const allocator_type& alloc = {})
+        : message(alloc), values(alloc) {}
+    ArenaEntry(const ArenaEntry& other, const allocator_type& alloc)
+        : timestamp(other.timestamp),
+          message(other.message, alloc),
+          values(other.values, alloc) {}
+    ArenaEntry(ArenaEntry&& other, const allocator_type& alloc)
+        : timestamp(other.timestamp),
+          message(std::move(other.message), alloc),
+          values(std::move(other.values), alloc) {}
+    ArenaEntry(const ArenaEntry&) = default;
+    ArenaEntry(ArenaEntry&&) = default;
+    ArenaEntry& operator=(const ArenaEntry&) = default;
+    ArenaEntry& operator=(ArenaEntry&&) = default;
+};
+}  // namespace
+
+TEST(parallel_read, thread_arenas) {
+    const auto entries = MakeEntries(1000);
+    std::vector<char> buffer;
+    ASSERT_GT(mpack_cpp::WriteBatch(entries, mpack_cpp::GrowableBuffer{buffer}), 0);
+
+    mpack_cpp::ThreadArenas arenas;
+    std::vector<ArenaEntry> after;
+    ASSERT_TRUE(mpack_cpp::ParallelReadFromMsgPack(buffer, after, arenas, 4));
+    ASSERT_EQ(after.size(), entries.size());
+    ASSERT_EQ(arenas.size(), 4);
+
+    // The items are split in 4 contiguous ranges of 250, one per thread.
+    for (std::size_t i = 0; i < after.size(); ++i) {
+        EXPECT_EQ(after[i].timestamp, entries[i].timestamp);
+        EXPECT_EQ(std::string_view(after[i].message), entries[i].message);
+        EXPECT_TRUE(std::equal(after[i].values.begin(), after[i].values.end(),
+                               entries[i].values.begin(), entries[i].values.end()));
+        auto* arena = arenas.Get(i / 250);
+        EXPECT_EQ(after[i].message.get_allocator().resource(), arena);
+        EXPECT_EQ(after[i].values.get_allocator().resource(), arena);
+    }
+}
+
+namespace {
+template <typename T>
+std::vector<char> SerialEncode(const std::vector<T>& items) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(items, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+}  // namespace
+
+TEST(parallel_for, exceptions_are_rethrown_after_join) {
+    // From a worker thread and from the calling thread, which takes range 0.
+    for (std::size_t failing : {std::size_t{2}, std::size_t{0}}) {
+        std::atomic<std::size_t> done{0};
+        auto work = [&](std::size_t thread, std::size_t begin, std::size_t end) {
+            if (thread == failing) {
+                throw std::runtime_error("decode failed");
+            }
+            done += end - begin;
+        };
+        EXPECT_THROW(mpack_cpp::internal::ParallelFor(4, 100, work), std::runtime_error);
+        // Every other range ran to completion before the exception was rethrown.
+        EXPECT_EQ(done.load(), 75);
+    }
+}
+
+TEST(parallel_write, identical_to_serial_encoder) {
+    for (std::uint64_t count : {0, 1, 15, 16, 1000}) {
+        const auto entries = MakeEntries(count);
+        for (std::size_t threads : {1, 4, 0}) {
+            std::vector<char> buffer;
+            auto n = mpack_cpp::ParallelWriteToMsgPack(
+                entries, mpack_cpp::GrowableBuffer{buffer}, threads);
+            EXPECT_EQ(n, buffer.size());
+            EXPECT_EQ(buffer, SerialEncode(entries));
+        }
+    }
+
+    // Large enough for an array32 header.
+    std::vector<std::int32_t> numbers(70000);
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+        numbers[i] = static_cast<std::int32_t>(i * i % 100003) - 50000;
+    }
+    std::vector<char> buffer;
+    mpack_cpp::ParallelWriteToMsgPack(numbers, mpack_cpp::GrowableBuffer{buffer}, 3);
+    EXPECT_EQ(buffer, SerialEncode(numbers));
+}
+
+#if __has_include(<sys/uio.h>)
+TEST(parallel_write, file_descriptor) {
+    const auto entries = MakeEntries(5000);
+    const auto expected = SerialEncode(entries);
+
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    auto n = mpack_cpp::ParallelWriteToMsgPack(
+        entries, mpack_cpp::FileDescriptor{fileno(file)}, 4);
+    ASSERT_EQ(n, expected.size());
+
+    std::vector<char> written(n);
+    std::rewind(file);
+    ASSERT_EQ(std::fread(written.data(), 1, n, file), n);
+    std::fclose(file);
+    EXPECT_EQ(written, expected);
+}
+#endif
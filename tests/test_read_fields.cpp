@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+constexpr std::size_t BUFFER_SIZE{1024};
+
+struct Telemetry {
+    std::uint32_t id;
+    std::string source;
+    double value;
+    std::optional<int> quality;
+    MPACK_CPP_DEFINE(Telemetry, id, source, value, quality)
+};
+
+/** Same data as `Telemetry` but written in a different order with an extra key. */
+struct Shuffled {
+    std::uint32_t id;
+    std::string source;
+    double value;
+    bool extra;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "value", value);
+        mpack_cpp::WriteField(writer, "extra", extra);
+        mpack_cpp::WriteField(writer, "source", source);
+        mpack_cpp::WriteField(writer, "id", id);
+    }
+};
+
+struct MissingValue {
+    std::uint32_t id;
+    std::string source;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "id", id);
+        mpack_cpp::WriteField(writer, "source", source);
+    }
+};
+}  // namespace
+
+TEST(read_fields, key_table_lookup) {
+    constexpr auto table = mpack_cpp::internal::MakeKeyTable(
+        std::array<std::string_view, 4>{"id", "source", "value", "quality"});
+    static_assert(table.sorted[0] == "id");
+    static_assert(table.sorted[3] == "value");
+    static_assert(table.Find("quality", 0) == 3);
+    static_assert(table.Find("source", 1) == 1);
+    static_assert(table.Find("unknown", 0) == 4);
+    static_assert(table.Find("", 4) == 4);
+}
+
+TEST(read_fields, in_order_with_optional) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    Telemetry before{7, "probe", 1.5, 3};
+    Telemetry after{};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.id, before.id);
+    EXPECT_EQ(after.source, before.source);
+    EXPECT_EQ(after.value, before.value);
+    EXPECT_EQ(after.quality, before.quality);
+}
+
+TEST(read_fields, any_order_and_missing_optional) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    Shuffled before{7, "probe", 1.5, true};
+    Telemetry after{0, "", 0.0, 8};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.id, before.id);
+    EXPECT_EQ(after.source, before.source);
+    EXPECT_EQ(after.value, before.value);
+    EXPECT_EQ(after.quality, std::nullopt);
+}
+
+TEST(read_fields, missing_required_field) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    MissingValue before{7, "probe"};
+    Telemetry after{};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    EXPECT_FALSE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+}
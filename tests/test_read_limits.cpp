@@ -0,0 +1,152 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Wide {
+    int f00;
+    int f01;
+    int f02;
+    int f03;
+    int f04;
+    int f05;
+    int f06;
+    int f07;
+    int f08;
+    int f09;
+    int f10;
+    int f11;
+    int f12;
+    int f13;
+    int f14;
+    int f15;
+    int f16;
+    int f17;
+    int f18;
+    int f19;
+    int f20;
+    int f21;
+    int f22;
+    int f23;
+    int f24;
+    int f25;
+    int f26;
+    int f27;
+    int f28;
+    int f29;
+    int f30;
+    int f31;
+    MPACK_CPP_EXPECT_DEFINE(Wide, f00, f01, f02, f03, f04, f05, f06, f07, f08, f09, f10,
+                            f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22,
+                            f23, f24, f25, f26, f27, f28, f29, f30, f31)
+};
+
+struct Message {
+    std::string text;
+    std::vector<std::int32_t> values;
+    MPACK_CPP_EXPECT_DEFINE(Message, text, values)
+};
+
+struct Samples {
+    std::vector<std::int32_t> counts;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "counts", mpack_cpp::Packed{counts});
+    }
+
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {
+        mpack_cpp::expect::ReadField(reader, "counts", mpack_cpp::Packed{counts});
+    }
+};
+}  // namespace
+
+TEST(read_limits, large_array_and_long_string) {
+    Message before{std::string(1000, 'x'), {}};
+    for (std::int32_t i = 0; i < 5000; ++i) {
+        before.values.push_back(i * 7 - 100);
+    }
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, 0);
+
+    Message after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.text, before.text);
+    EXPECT_EQ(after.values, before.values);
+}
+
+TEST(read_limits, wide_struct) {
+    Wide before{1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16,
+                17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, 0);
+
+    Wide after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.f00, 1);
+    EXPECT_EQ(after.f17, 18);
+    EXPECT_EQ(after.f31, 32);
+}
+
+TEST(read_limits, string_with_embedded_null) {
+    std::string before{"ab\0cd", 5};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+
+    std::string after;
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after, before);
+}
+
+TEST(read_limits, limits_are_enforced) {
+    Message before{"hello", {1, 2, 3, 4}};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+
+    Message after{};
+    mpack_cpp::expect::ReadLimits limits{};
+    limits.max_array_size = 3;
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+
+    limits = mpack_cpp::expect::ReadLimits{};
+    limits.max_str_size = 4;
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+
+    limits = mpack_cpp::expect::ReadLimits{};
+    limits.max_map_size = 1;
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+
+    limits = mpack_cpp::expect::ReadLimits{};
+    limits.max_array_size = 4;
+    limits.max_str_size = 5;
+    limits.max_map_size = 2;
+    EXPECT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+    EXPECT_EQ(after.text, before.text);
+    EXPECT_EQ(after.values, before.values);
+}
+
+TEST(read_limits, packed_bin_size) {
+    Samples before{{1, 2, 3, 4}};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+
+    Samples after{};
+    mpack_cpp::expect::ReadLimits limits{};
+    limits.max_bin_size = 15;
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+    limits.max_bin_size = 16;
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, buffer, n, limits));
+    EXPECT_EQ(after.counts, before.counts);
+
+    // A bin32 header claiming 4 GiB is rejected before anything is allocated.
+    const char huge[] = {'\x81', '\xa6', 'c',    'o',    'u',   'n',
+                         't',     's',     '\xc6', '\xff', '\xff', '\xff', '\xff'};
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, huge, sizeof(huge)));
+    EXPECT_LE(after.counts.capacity(), before.counts.size());
+}
@@ -0,0 +1,179 @@
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_ring.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Tick {
+    std::uint32_t producer;
+    std::uint32_t seq;
+    double price;
+    MPACK_CPP_DEFINE(Tick, producer, seq, price)
+};
+
+struct Note {
+    std::uint32_t seq;
+    std::string text;
+    MPACK_CPP_DEFINE(Note, seq, text)
+};
+
+struct NoteView {
+    std::uint32_t seq;
+    std::string_view text;
+    MPACK_CPP_DEFINE(NoteView, seq, text)
+};
+
+std::string RingName(const char* test) {
+    return "/mpack_cpp_" + std::string(test) + "_" + std::to_string(getpid());
+}
+
+/** Creates a ring and removes its name again. */
+struct ScopedRing {
+    std::string name;
+    mpack_cpp::SharedRing ring;
+
+    ScopedRing(std::string ring_name, std::size_t capacity,
+               mpack_cpp::RingProducers producers = mpack_cpp::RingProducers::kSingle)
+        : name(std::move(ring_name)) {
+        mpack_cpp::SharedRing::Remove(name);
+        ring = mpack_cpp::SharedRing(name, capacity, producers);
+    }
+    ~ScopedRing() { mpack_cpp::SharedRing::Remove(name); }
+};
+}  // namespace
+
+TEST(shared_ring, variable_size_records_wrap_around) {
+    ScopedRing producer(RingName("wrap"), 4096);
+    ASSERT_TRUE(producer.ring.is_open());
+    mpack_cpp::SharedRing consumer(producer.name);
+    ASSERT_TRUE(consumer.is_open());
+    EXPECT_EQ(consumer.capacity(), 4096);
+
+    // Many times the capacity, with records of varying size.
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        Note before{i, std::string(i % 300, 'n')};
+        ASSERT_TRUE(producer.ring.Write(before));
+        Note after{};
+        ASSERT_EQ(consumer.TryRead(after), mpack_cpp::SharedRing::Status::kRead);
+        EXPECT_EQ(after.seq, i);
+        EXPECT_EQ(after.text, before.text);
+    }
+    Note after{};
+    EXPECT_EQ(consumer.TryRead(after), mpack_cpp::SharedRing::Status::kEmpty);
+}
+
+TEST(shared_ring, full_ring) {
+    ScopedRing producer(RingName("full"), 4096);
+    mpack_cpp::SharedRing consumer(producer.name);
+
+    Tick tick{0, 0, 1.0};
+    std::uint32_t written{0};
+    while (producer.ring.Write(tick)) {
+        tick.seq = ++written;
+    }
+    EXPECT_GT(written, 0);
+    EXPECT_LE(written * mpack_cpp::MaxEncodedSize<Tick>(), 4096);
+
+    // Releasing one record makes room for the next one.
+    Tick after{};
+    ASSERT_EQ(consumer.TryRead(after), mpack_cpp::SharedRing::Status::kRead);
+    EXPECT_EQ(after.seq, 0);
+    EXPECT_TRUE(producer.ring.Write(tick));
+
+    // Records larger than half the ring are refused.
+    mpack_cpp::SharedRing::Slot slot;
+    EXPECT_FALSE(producer.ring.Reserve(producer.ring.max_record_size() + 1, slot));
+}
+
+TEST(shared_ring, unopened_ring) {
+    mpack_cpp::SharedRing unopened;
+    mpack_cpp::SharedRing missing(RingName("missing"));
+    for (auto* ring : {&unopened, &missing}) {
+        EXPECT_FALSE(ring->is_open());
+        EXPECT_EQ(ring->max_record_size(), 0);
+        EXPECT_FALSE(ring->Write(Tick{0, 0, 1.0}));
+        mpack_cpp::SharedRing::Slot slot;
+        EXPECT_FALSE(ring->Reserve(8, slot));
+        mpack_cpp::BytesView record;
+        EXPECT_FALSE(ring->Peek(record));
+        ring->Release();
+        Tick after{};
+        EXPECT_EQ(ring->TryRead(after), mpack_cpp::SharedRing::Status::kEmpty);
+    }
+}
+
+TEST(shared_ring, zero_copy_peek) {
+    ScopedRing producer(RingName("peek"), 4096);
+    mpack_cpp::SharedRing consumer(producer.name);
+    ASSERT_TRUE(producer.ring.Write(Note{7, "straight from shared memory"}));
+
+    mpack_cpp::BytesView record;
+    ASSERT_TRUE(consumer.Peek(record));
+    NoteView view{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(view, record.data, record.size));
+    EXPECT_EQ(view.text, "straight from shared memory");
+    EXPECT_GE(view.text.data(), record.data);
+    consumer.Release();
+    EXPECT_FALSE(consumer.Peek(record));
+}
+
+TEST(shared_ring, aborted_slots_are_skipped) {
+    ScopedRing producer(RingName("abort"), 4096);
+    mpack_cpp::SharedRing consumer(producer.name);
+
+    mpack_cpp::SharedRing::Slot slot;
+    ASSERT_TRUE(producer.ring.Reserve(100, slot));
+    ASSERT_TRUE(producer.ring.Write(Tick{0, 1, 2.0}));
+    mpack_cpp::BytesView record;
+    EXPECT_FALSE(consumer.Peek(record));  // Blocked by the uncommitted slot.
+
+    producer.ring.Abort(slot);
+    Tick after{};
+    ASSERT_EQ(consumer.TryRead(after), mpack_cpp::SharedRing::Status::kRead);
+    EXPECT_EQ(after.seq, 1);
+}
+
+TEST(shared_ring, multiple_producers) {
+    constexpr std::uint32_t kProducers{4};
+    constexpr std::uint32_t kCount{5000};
+    ScopedRing producer(RingName("mpsc"), 8192, mpack_cpp::RingProducers::kMultiple);
+    mpack_cpp::SharedRing consumer(producer.name);
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&producer, p] {
+            for (std::uint32_t i = 0; i < kCount; ++i) {
+                while (!producer.ring.Write(Tick{p, i, 0.5 * i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Records of every producer arrive in order.
+    std::vector<std::uint32_t> next(kProducers, 0);
+    for (std::uint32_t received = 0; received < kProducers * kCount;) {
+        Tick tick{};
+        auto status = consumer.TryRead(tick);
+        if (status == mpack_cpp::SharedRing::Status::kEmpty) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(status, mpack_cpp::SharedRing::Status::kRead);
+        ASSERT_LT(tick.producer, kProducers);
+        EXPECT_EQ(tick.seq, next[tick.producer]++);
+        ++received;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
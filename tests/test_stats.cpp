@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_stats.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Order {
+    std::uint32_t id;
+    std::string customer;
+    std::vector<std::uint16_t> items;
+    MPACK_CPP_DEFINE(Order, id, customer, items)
+};
+
+// No map size, encoded through the mpack map builder.
+struct Envelope {
+    Order order;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "order", order);
+    }
+};
+
+static_assert(mpack_cpp::kStatsEnabled, "Build with MPACK_CPP_INSTRUMENTATION.");
+
+int callback_calls{0};
+void CountCall(const mpack_cpp::CallStats&) { ++callback_calls; }
+}  // namespace
+
+TEST(stats, encode_and_decode) {
+    Envelope before{{42, "a customer with a long name", {1, 2, 3}}};
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(before, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n, 0);
+    auto encode = mpack_cpp::LastCallStats();
+    EXPECT_EQ(encode.operation, mpack_cpp::CallStats::Operation::kEncode);
+    EXPECT_EQ(encode.bytes_out, n);
+    EXPECT_EQ(encode.map_builds, 1);
+
+    // Decode the order, behind the fixmap and "order" key of the envelope.
+    constexpr std::size_t kOffset{7};
+    Order after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer.data() + kOffset, n - kOffset));
+    auto decode = mpack_cpp::LastCallStats();
+    EXPECT_EQ(decode.operation, mpack_cpp::CallStats::Operation::kDecode);
+    EXPECT_EQ(decode.bytes_in, n - kOffset);
+    EXPECT_EQ(decode.nodes, 10);  // Map, 3 keys, 2 values, array and 3 items.
+    EXPECT_EQ(decode.container_allocations, 2);
+
+    // Reusing the destination does not allocate again.
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer.data() + kOffset, n - kOffset));
+    EXPECT_EQ(mpack_cpp::LastCallStats().container_allocations, 0);
+}
+
+TEST(stats, callback) {
+    Order order{1, "c", {}};
+    std::vector<char> buffer;
+    mpack_cpp::SetStatsCallback(CountCall);
+    callback_calls = 0;
+    mpack_cpp::WriteToMsgPack(order, mpack_cpp::GrowableBuffer{buffer});
+    mpack_cpp::ReadFromMsgPack(order, buffer.data(), buffer.size());
+
+    std::vector<std::uint16_t> items{1, 2};
+    buffer.clear();
+    mpack_cpp::WriteToMsgPack(items, mpack_cpp::GrowableBuffer{buffer});
+    mpack_cpp::expect::ReadFromMsgPack(items, buffer.data(), buffer.size());
+    mpack_cpp::SetStatsCallback(nullptr);
+    EXPECT_EQ(callback_calls, 4);
+}
+
+TEST(stats, streamed_bytes_in_are_decoded_bytes) {
+    std::vector<std::uint16_t> first{1, 2};
+    std::vector<std::uint16_t> second{3, 4, 500};
+    std::vector<char> buffer;
+    auto n_first = mpack_cpp::WriteToMsgPack(first, mpack_cpp::GrowableBuffer{buffer});
+    auto n_second = mpack_cpp::WriteToMsgPack(second, mpack_cpp::GrowableBuffer{buffer});
+    ASSERT_GT(n_first, 0);
+    ASSERT_GT(n_second, 0);
+    const std::string input(buffer.data(), buffer.size());
+
+    // Both messages are read with the first fill, each call counts its own.
+    std::istringstream stream(input);
+    mpack_cpp::expect::StreamReader reader(stream);
+    std::vector<std::uint16_t> after;
+    ASSERT_TRUE(reader.Read(after));
+    EXPECT_EQ(mpack_cpp::LastCallStats().bytes_in, n_first);
+    ASSERT_TRUE(reader.Read(after));
+    EXPECT_EQ(mpack_cpp::LastCallStats().bytes_in, n_second);
+
+    // The one-shot overload discards the second message, it is not counted.
+    std::istringstream one_shot(input);
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, one_shot));
+    EXPECT_EQ(mpack_cpp::LastCallStats().bytes_in, n_first);
+}
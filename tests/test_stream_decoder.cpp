@@ -0,0 +1,116 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+using Status = mpack_cpp::StreamDecoder::Status;
+
+struct Reading {
+    std::uint16_t sensor;
+    std::vector<float> values;
+    std::string unit;
+    MPACK_CPP_DEFINE(Reading, sensor, values, unit)
+};
+
+std::vector<Reading> MakeReadings() {
+    return {{1, {0.5f, 1.5f}, "V"}, {2, std::vector<float>(100, 2.0f), "A"}, {3, {}, ""}};
+}
+
+std::vector<char> Encode(const std::vector<Reading>& readings) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteBatch(readings, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+}  // namespace
+
+TEST(stream_decoder, feed_byte_by_byte) {
+    const auto readings = MakeReadings();
+    const auto buffer = Encode(readings);
+
+    mpack_cpp::StreamDecoder decoder;
+    std::size_t next{0};
+    Reading reading{};
+    EXPECT_EQ(decoder.TryRead(reading), Status::kIncomplete);
+    for (char byte : buffer) {
+        decoder.Feed(&byte, 1);
+        auto status = decoder.TryRead(reading);
+        ASSERT_NE(status, Status::kError);
+        if (status == Status::kComplete) {
+            ASSERT_LT(next, readings.size());
+            EXPECT_EQ(reading.sensor, readings[next].sensor);
+            EXPECT_EQ(reading.values, readings[next].values);
+            EXPECT_EQ(reading.unit, readings[next].unit);
+            ++next;
+        }
+    }
+    EXPECT_EQ(next, readings.size());
+    EXPECT_EQ(decoder.TryRead(reading), Status::kIncomplete);
+}
+
+TEST(stream_decoder, two_messages_per_feed) {
+    const std::vector<Reading> pair{{1, {0.5f}, "V"}, {2, {1.5f}, "A"}};
+    const auto buffer = Encode(pair);
+
+    mpack_cpp::StreamDecoder decoder;
+    Reading reading{};
+    for (int round{0}; round < 1000; ++round) {
+        ASSERT_TRUE(decoder.Feed(buffer.data(), buffer.size()));
+        EXPECT_LE(decoder.buffered(), buffer.size());
+        ASSERT_EQ(decoder.TryRead(reading), Status::kComplete);
+        EXPECT_EQ(reading.sensor, 1);
+        // The second message is still pending, feeding more is refused.
+        if (decoder.buffered() != 0) {
+            EXPECT_FALSE(decoder.Feed(buffer.data(), buffer.size()));
+        }
+        ASSERT_EQ(decoder.TryRead(reading), Status::kComplete);
+        EXPECT_EQ(reading.sensor, 2);
+        ASSERT_EQ(decoder.TryRead(reading), Status::kIncomplete);
+        EXPECT_EQ(decoder.buffered(), 0);
+    }
+}
+
+TEST(stream_decoder, non_blocking_file_descriptor) {
+    const auto readings = MakeReadings();
+    const auto buffer = Encode(readings);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+
+    mpack_cpp::StreamDecoder decoder(mpack_cpp::FileDescriptor{fds[0]});
+    Reading reading{};
+    EXPECT_EQ(decoder.TryRead(reading), Status::kIncomplete);
+
+    // First half of the data, the first message is complete.
+    const std::size_t half = buffer.size() / 2;
+    ASSERT_EQ(write(fds[1], buffer.data(), half), static_cast<ssize_t>(half));
+    EXPECT_EQ(decoder.TryRead(reading), Status::kComplete);
+    EXPECT_EQ(reading.sensor, 1);
+    EXPECT_EQ(decoder.TryRead(reading), Status::kIncomplete);
+
+    ASSERT_EQ(write(fds[1], buffer.data() + half, buffer.size() - half),
+              static_cast<ssize_t>(buffer.size() - half));
+    EXPECT_EQ(decoder.TryRead(reading), Status::kComplete);
+    EXPECT_EQ(reading.sensor, 2);
+    EXPECT_EQ(decoder.TryRead(reading), Status::kComplete);
+    EXPECT_EQ(reading.sensor, 3);
+
+    close(fds[1]);
+    EXPECT_EQ(decoder.TryRead(reading), Status::kError);
+    close(fds[0]);
+}
+
+TEST(stream_decoder, invalid_input) {
+    mpack_cpp::StreamDecoder decoder;
+    const char invalid[] = {'\xc1'};
+    decoder.Feed(invalid, sizeof(invalid));
+    Reading reading{};
+    EXPECT_EQ(decoder.TryRead(reading), Status::kError);
+}
@@ -0,0 +1,196 @@
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_expect_reader.hpp"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Channel {
+    std::string name;
+    std::vector<double> samples;
+    std::optional<std::int32_t> gain;
+
+    void to_message_pack(mpack_cpp::WriteCtx& writer) const {
+        mpack_cpp::WriteField(writer, "name", name);
+        mpack_cpp::WriteField(writer, "samples", samples);
+        mpack_cpp::WriteOptionalField(writer, "gain", gain);
+    }
+
+    void from_message_pack(mpack_cpp::expect::ReadCtx& reader) {
+        mpack_cpp::expect::ReadField(reader, "name", name);
+        mpack_cpp::expect::ReadField(reader, "samples", samples);
+        mpack_cpp::expect::ReadOptionalField(reader, "gain", gain);
+    }
+};
+
+struct Recording {
+    std::vector<Channel> channels;
+    std::uint64_t id;
+    MPACK_CPP_EXPECT_DEFINE(Recording, channels, id)
+};
+
+Recording MakeRecording() {
+    Recording recording{{}, 42};
+    for (int c = 0; c < 4; ++c) {
+        Channel channel{std::string(static_cast<std::size_t>(50 + c), 'a'), {}, {}};
+        for (int i = 0; i < 300; ++i) {
+            channel.samples.push_back(i * 0.25 - c);
+        }
+        if (c % 2 == 0) {
+            channel.gain = c * 10;
+        }
+        recording.channels.push_back(channel);
+    }
+    return recording;
+}
+
+std::vector<char> Encode(const Recording& recording) {
+    std::vector<char> buffer;
+    auto n = mpack_cpp::WriteToMsgPack(recording, mpack_cpp::GrowableBuffer{buffer});
+    EXPECT_GT(n, 0);
+    return buffer;
+}
+
+void ExpectEqual(const Recording& actual, const Recording& expected) {
+    EXPECT_EQ(actual.id, expected.id);
+    ASSERT_EQ(actual.channels.size(), expected.channels.size());
+    for (std::size_t i = 0; i < expected.channels.size(); ++i) {
+        EXPECT_EQ(actual.channels[i].name, expected.channels[i].name);
+        EXPECT_EQ(actual.channels[i].samples, expected.channels[i].samples);
+        EXPECT_EQ(actual.channels[i].gain, expected.channels[i].gain);
+    }
+}
+}  // namespace
+
+TEST(stream_reader, fill_function_with_small_chunks) {
+    const auto before = MakeRecording();
+    const auto buffer = Encode(before);
+
+    // Hand out the data in odd sized chunks, so values straddle buffer refills.
+    std::size_t offset{0};
+    mpack_cpp::expect::FillFunction fill = [&](char* out, std::size_t count) {
+        auto n = std::min<std::size_t>({count, 7, buffer.size() - offset});
+        std::copy_n(buffer.data() + offset, n, out);
+        offset += n;
+        return n;
+    };
+
+    Recording after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, fill, {}, 64));
+    ExpectEqual(after, before);
+    EXPECT_EQ(offset, buffer.size());
+}
+
+TEST(stream_reader, istream) {
+    const auto before = MakeRecording();
+    const auto buffer = Encode(before);
+    std::istringstream stream(std::string(buffer.data(), buffer.size()));
+
+    Recording after{};
+    ASSERT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, stream, {}, 128));
+    ExpectEqual(after, before);
+}
+
+#if __has_include(<unistd.h>)
+TEST(stream_reader, file_descriptor) {
+    Recording before{{Channel{"short", {1.0, 2.0}, 3}}, 7};
+    const auto buffer = Encode(before);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], buffer.data(), buffer.size()),
+              static_cast<ssize_t>(buffer.size()));
+    close(fds[1]);
+
+    Recording after{};
+    mpack_cpp::FileDescriptor file{fds[0]};
+    EXPECT_TRUE(mpack_cpp::expect::ReadFromMsgPack(after, file));
+    close(fds[0]);
+    ExpectEqual(after, before);
+}
+
+TEST(stream_reader, consecutive_messages_on_pipe) {
+    Recording first{{Channel{"first", {1.0}, {}}}, 1};
+    Recording second{{Channel{"second", {2.0, 3.0}, 4}}, 2};
+    auto buffer = Encode(first);
+    const auto second_buffer = Encode(second);
+    buffer.insert(buffer.end(), second_buffer.begin(), second_buffer.end());
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], buffer.data(), buffer.size()),
+              static_cast<ssize_t>(buffer.size()));
+    close(fds[1]);
+
+    // Both messages arrive with the first read.
+    mpack_cpp::expect::StreamReader stream(mpack_cpp::FileDescriptor{fds[0]});
+    Recording after{};
+    ASSERT_TRUE(stream.Read(after));
+    ExpectEqual(after, first);
+    EXPECT_EQ(stream.buffered(), second_buffer.size());
+    ASSERT_TRUE(stream.Read(after));
+    ExpectEqual(after, second);
+    EXPECT_EQ(stream.buffered(), 0);
+    EXPECT_FALSE(stream.Read(after));
+    EXPECT_TRUE(stream.eof());
+    close(fds[0]);
+}
+
+TEST(stream_reader, read_error_is_not_eof) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[1]);
+    close(fds[0]);
+
+    // The file descriptor is closed, reading it fails with EBADF.
+    Recording after{};
+    mpack_cpp::expect::StreamReader stream(mpack_cpp::FileDescriptor{fds[0]});
+    EXPECT_FALSE(stream.Read(after));
+    EXPECT_FALSE(stream.eof());
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after,
+                                                    mpack_cpp::FileDescriptor{fds[0]}));
+}
+#endif
+
+TEST(stream_reader, consecutive_messages) {
+    const auto first = MakeRecording();
+    Recording second{{Channel{"second", {2.0, 3.0}, 4}}, 2};
+    auto buffer = Encode(first);
+    const auto second_buffer = Encode(second);
+    buffer.insert(buffer.end(), second_buffer.begin(), second_buffer.end());
+    std::istringstream input(std::string(buffer.data(), buffer.size()));
+
+    // The small buffer makes the first message end in the middle of a refill.
+    mpack_cpp::expect::StreamReader stream(input, {}, 100);
+    Recording after{};
+    ASSERT_TRUE(stream.Read(after));
+    ExpectEqual(after, first);
+    ASSERT_TRUE(stream.Read(after));
+    ExpectEqual(after, second);
+    EXPECT_FALSE(stream.eof());
+    // The input ends cleanly between messages.
+    EXPECT_FALSE(stream.Read(after));
+    EXPECT_TRUE(stream.eof());
+}
+
+TEST(stream_reader, truncated_input) {
+    const auto buffer = Encode(MakeRecording());
+    std::istringstream stream(std::string(buffer.data(), buffer.size() / 2));
+
+    Recording after{};
+    EXPECT_FALSE(mpack_cpp::expect::ReadFromMsgPack(after, stream));
+
+    // A message that ends early is an error, not the end of the input.
+    std::istringstream input(std::string(buffer.data(), buffer.size() / 2));
+    mpack_cpp::expect::StreamReader reader(input);
+    EXPECT_FALSE(reader.Read(after));
+    EXPECT_FALSE(reader.eof());
+}
@@ -0,0 +1,116 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+struct Block {
+    std::string label;
+    std::vector<double> values;
+    MPACK_CPP_DEFINE(Block, label, values)
+};
+
+struct Snapshot {
+    std::vector<Block> blocks;
+    std::uint32_t version;
+    MPACK_CPP_DEFINE(Snapshot, blocks, version)
+};
+
+Snapshot MakeSnapshot() {
+    Snapshot snapshot{{}, 3};
+    for (int b = 0; b < 8; ++b) {
+        Block block{std::string(static_cast<std::size_t>(100 * b), 'x'), {}};
+        for (int i = 0; i < 1000; ++i) {
+            block.values.push_back(i * 0.5 + b);
+        }
+        snapshot.blocks.push_back(block);
+    }
+    return snapshot;
+}
+
+std::vector<char> Encode(const Snapshot& snapshot) {
+    std::vector<char> buffer;
+    mpack_cpp::WriteToMsgPack(snapshot, mpack_cpp::GrowableBuffer{buffer});
+    return buffer;
+}
+}  // namespace
+
+TEST(stream_writer, flush_function) {
+    const auto snapshot = MakeSnapshot();
+    const auto expected = Encode(snapshot);
+
+    std::vector<char> out;
+    mpack_cpp::FlushFunction flush = [&](const char* data, std::size_t count) {
+        out.insert(out.end(), data, data + count);
+        return true;
+    };
+    auto n = mpack_cpp::WriteToMsgPack(snapshot, flush, 256);
+    EXPECT_EQ(n, expected.size());
+    EXPECT_EQ(out, expected);
+}
+
+TEST(stream_writer, bounded_flushes) {
+    // Only writes that do not fit in the scratch buffer are flushed in one piece,
+    // the longest one is the last label of 700 bytes.
+    std::size_t largest_flush{0};
+    mpack_cpp::FlushFunction flush = [&](const char*, std::size_t count) {
+        largest_flush = std::max(largest_flush, count);
+        return true;
+    };
+    EXPECT_GT(mpack_cpp::WriteToMsgPack(MakeSnapshot(), flush, 256), 0);
+    EXPECT_LE(largest_flush, 700);
+}
+
+TEST(stream_writer, ostream) {
+    const auto snapshot = MakeSnapshot();
+    const auto expected = Encode(snapshot);
+
+    std::ostringstream stream;
+    auto n = mpack_cpp::WriteToMsgPack(snapshot, stream, 512);
+    EXPECT_EQ(n, expected.size());
+    EXPECT_EQ(stream.str(), std::string(expected.begin(), expected.end()));
+
+    Snapshot after{};
+    auto text = stream.str();
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, text.data(), text.size()));
+    EXPECT_EQ(after.version, snapshot.version);
+    ASSERT_EQ(after.blocks.size(), snapshot.blocks.size());
+    EXPECT_EQ(after.blocks.back().values, snapshot.blocks.back().values);
+}
+
+TEST(stream_writer, file_descriptor) {
+    Block block{"pipe", {1.0, 2.0, 3.0}};
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    auto n = mpack_cpp::WriteToMsgPack(block, mpack_cpp::FileDescriptor{fds[1]});
+    close(fds[1]);
+
+    std::vector<char> in(1024);
+    auto read_n = read(fds[0], in.data(), in.size());
+    close(fds[0]);
+    ASSERT_GT(n, 0);
+    ASSERT_EQ(read_n, static_cast<ssize_t>(n));
+
+    Block after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, in.data(), n));
+    EXPECT_EQ(after.label, block.label);
+    EXPECT_EQ(after.values, block.values);
+}
+
+TEST(stream_writer, failing_sink) {
+    std::size_t calls{0};
+    mpack_cpp::FlushFunction flush = [&](const char*, std::size_t) {
+        ++calls;
+        return false;
+    };
+    EXPECT_EQ(mpack_cpp::WriteToMsgPack(MakeSnapshot(), flush, 64), 0);
+    EXPECT_GE(calls, 1);
+}
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpack_cpp/mpack_macros.hpp"
+#include "mpack_cpp/mpack_reader.hpp"
+#include "mpack_cpp/mpack_types.hpp"
+#include "mpack_cpp/mpack_writer.hpp"
+
+namespace {
+constexpr std::size_t BUFFER_SIZE{1024};
+
+struct Owning {
+    std::string topic;
+    std::string payload;
+    MPACK_CPP_DEFINE(Owning, topic, payload)
+};
+
+struct Viewing {
+    std::string_view topic;
+    mpack_cpp::BytesView payload;
+    MPACK_CPP_DEFINE(Viewing, topic, payload)
+};
+
+bool PointsInto(const char* ptr, const std::vector<char>& buffer) {
+    return ptr >= buffer.data() && ptr < buffer.data() + buffer.size();
+}
+}  // namespace
+
+TEST(zero_copy, string_view_points_into_buffer) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    Owning before{"sensors/left", "some payload"};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+
+    // Read the 'str' payload as string_view too, it is a valid view on any 'str'.
+    struct {
+        std::string_view topic;
+        std::string_view payload;
+        void from_message_pack(mpack_cpp::ReadCtx& node) {
+            mpack_cpp::ReadField(node, "topic", topic);
+            mpack_cpp::ReadField(node, "payload", payload);
+        }
+    } after;
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.topic, before.topic);
+    EXPECT_EQ(after.payload, before.payload);
+    EXPECT_TRUE(PointsInto(after.topic.data(), buffer));
+    EXPECT_TRUE(PointsInto(after.payload.data(), buffer));
+}
+
+TEST(zero_copy, bytes_view_round_trip) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    const std::string data{'\x00', '\x01', '\xfe', '\xff'};
+    Viewing before{"raw", mpack_cpp::BytesView{data.data(), data.size()}};
+    auto n = mpack_cpp::WriteToMsgPack(before, buffer);
+    EXPECT_EQ(n, 25);
+
+    Viewing after{};
+    ASSERT_TRUE(mpack_cpp::ReadFromMsgPack(after, buffer, n));
+    EXPECT_EQ(after.topic, "raw");
+    ASSERT_EQ(after.payload.size, data.size());
+    EXPECT_EQ(std::string(after.payload.data, after.payload.size), data);
+    EXPECT_TRUE(PointsInto(after.payload.data, buffer));
+}